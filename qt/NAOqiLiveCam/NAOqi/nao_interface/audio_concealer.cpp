@@ -0,0 +1,199 @@
+/**
+ * Gap detection and loss concealment for the received audio
+ * Created 2026/10/19
+ */
+
+#include "audio_concealer.h"
+#include "nao_time.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+static const int HISTORY_SAMPLES = 512;
+static const int WINDOW_SAMPLES = 256;						// correlation window
+static const int MIN_PERIOD = SAMPLERATE_IN / 400;			// 400 Hz
+static const int MAX_PERIOD = HISTORY_SAMPLES - WINDOW_SAMPLES;	// 62.5 Hz
+static const int SEARCH_BUDGET = 65536;						// multiply-adds per pitch search
+
+static const long long GAP_TOLERANCE_USECS = 10000;
+static const long long MAX_CONCEAL_USECS = 120000;
+static const int CROSSFADE_SAMPLES = SAMPLERATE_IN * 4 / 1000;
+static const int FULL_GAIN_SAMPLES = SAMPLERATE_IN * 10 / 1000;	// then fades out
+static const int FADE_OUT_SAMPLES = SAMPLERATE_IN * 50 / 1000;
+
+AudioConcealer::AudioConcealer()
+	: m_expectedTimestamp(0)
+	, m_history(HISTORY_SAMPLES)
+	, m_historyFill(0)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	m_stats.blocks = 0;
+	m_stats.gaps = 0;
+	m_stats.outages = 0;
+	m_stats.lostUSecs = 0;
+	m_stats.concealedUSecs = 0;
+	m_stats.lastConcealUSecs = 0;
+}
+
+AudioConcealer::~AudioConcealer()
+{
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void AudioConcealer::reset()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_expectedTimestamp = 0;
+	m_historyFill = 0;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void AudioConcealer::getStats(NaoAudioStats &stats) const
+{
+	pthread_mutex_lock(&m_mutex);
+	stats = m_stats;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+const short* AudioConcealer::process(const short *data, int samples, long long timestamp,
+									 std::vector<short> &concealed, int *outSamples, long long *outTimestamp)
+{
+	pthread_mutex_lock(&m_mutex);
+	long long start = getTimeUSecs();
+	m_stats.blocks++;
+
+	int gapSamples = 0;
+	bool fadeIn = false;
+	if (m_expectedTimestamp > 0)
+	{
+		long long delta = timestamp - m_expectedTimestamp;
+		if (delta > GAP_TOLERANCE_USECS)
+		{
+			m_stats.gaps++;
+			m_stats.lostUSecs += delta;
+			if (delta <= MAX_CONCEAL_USECS && m_historyFill == HISTORY_SAMPLES)
+			{
+				gapSamples = (int)(delta * SAMPLERATE_IN / 1000000);
+			}
+			else
+			{
+				m_stats.outages++;
+				fadeIn = true;
+			}
+		}
+		else if (delta < -MAX_CONCEAL_USECS)
+		{
+			// the robot clock went back (reconnect): a new stream
+			m_historyFill = 0;
+		}
+	}
+	m_expectedTimestamp = timestamp + (long long) samples * 1000000 / SAMPLERATE_IN;
+
+	const short *result = data;
+	*outSamples = samples;
+	*outTimestamp = timestamp;
+	if (gapSamples > 0 || fadeIn)
+	{
+		// both buffers only grow up to the largest block plus gap seen
+		int crossfade = std::min(CROSSFADE_SAMPLES, samples);
+		if ((int) concealed.size() < gapSamples + samples)
+			concealed.resize(gapSamples + samples);
+		if ((int) m_synthetic.size() < gapSamples + crossfade)
+			m_synthetic.resize(gapSamples + crossfade);
+
+		short *out = &concealed[0];
+		if (gapSamples > 0)
+		{
+			// the synthetic waveform runs on under the crossfade
+			synthesize(&m_synthetic[0], gapSamples + crossfade, estimatePeriod());
+			memcpy(out, &m_synthetic[0], gapSamples * sizeof(short));
+		}
+		for (int i = 0; i < samples; i++)
+		{
+			int value = data[i];
+			if (i < crossfade)
+			{
+				int synthetic = gapSamples > 0 ? m_synthetic[gapSamples + i] : 0;
+				value = (synthetic * (crossfade - i) + value * i) / crossfade;
+			}
+			out[gapSamples + i] = (short) value;
+		}
+
+		result = out;
+		*outSamples = gapSamples + samples;
+		*outTimestamp = timestamp - (long long) gapSamples * 1000000 / SAMPLERATE_IN;
+		m_stats.concealedUSecs += (long long) gapSamples * 1000000 / SAMPLERATE_IN;
+		m_stats.lastConcealUSecs = (int)(getTimeUSecs() - start);
+	}
+	appendHistory(result, *outSamples);
+
+	pthread_mutex_unlock(&m_mutex);
+	return result;
+}
+
+// Pitch period of the newest samples by normalized autocorrelation. The lag
+// step is chosen so the search stays within SEARCH_BUDGET, then the best
+// lag is refined between the coarse steps. Called with the mutex held.
+int AudioConcealer::estimatePeriod() const
+{
+	const short *x = &m_history[HISTORY_SAMPLES - WINDOW_SAMPLES];
+	int lags = MAX_PERIOD - MIN_PERIOD + 1;
+	int step = std::max(1, (lags * WINDOW_SAMPLES * 2 + SEARCH_BUDGET - 1) / SEARCH_BUDGET);
+
+	int best = MIN_PERIOD;
+	float bestScore = -1.0f;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		int first = pass == 0 ? MIN_PERIOD : std::max(MIN_PERIOD, best - step + 1);
+		int last = pass == 0 ? MAX_PERIOD : std::min(MAX_PERIOD, best + step - 1);
+		int increment = pass == 0 ? step : 1;
+		for (int lag = first; lag <= last; lag += increment)
+		{
+			float correlation = 0.0f;
+			float energy = 0.0f;
+			for (int n = 0; n < WINDOW_SAMPLES; n++)
+			{
+				float delayed = x[n - lag];
+				correlation += x[n] * delayed;
+				energy += delayed * delayed;
+			}
+			float score = correlation / std::sqrt(energy + 1.0f);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				best = lag;
+			}
+		}
+		if (step == 1)
+			break;
+	}
+	return best;
+}
+
+// Repeats the last pitch period, full level for 10 ms then fading to
+// silence so a long gap does not turn into a buzz.
+void AudioConcealer::synthesize(short *out, int samples, int period) const
+{
+	const short *source = &m_history[HISTORY_SAMPLES - period];
+	for (int i = 0; i < samples; i++)
+	{
+		float gain = i < FULL_GAIN_SAMPLES ? 1.0f
+				   : std::max(0.0f, 1.0f - (float)(i - FULL_GAIN_SAMPLES) / FADE_OUT_SAMPLES);
+		out[i] = (short)(source[i % period] * gain);
+	}
+}
+
+void AudioConcealer::appendHistory(const short *data, int samples)
+{
+	if (samples >= HISTORY_SAMPLES)
+	{
+		memcpy(&m_history[0], data + samples - HISTORY_SAMPLES, HISTORY_SAMPLES * sizeof(short));
+	}
+	else
+	{
+		memmove(&m_history[0], &m_history[samples], (HISTORY_SAMPLES - samples) * sizeof(short));
+		memcpy(&m_history[HISTORY_SAMPLES - samples], data, samples * sizeof(short));
+	}
+	m_historyFill = std::min(HISTORY_SAMPLES, m_historyFill + samples);
+}
@@ -0,0 +1,53 @@
+/**
+ * Gap detection and loss concealment for the received audio
+ * Created 2026/10/19
+ */
+
+#ifndef AUDIO_CONCEALER_H
+#define AUDIO_CONCEALER_H
+
+#include <vector>
+#include <pthread.h>
+
+#include "nao_interface.h"
+
+/**
+ * Gap detection and packet loss concealment for the 16 kHz capture stream.
+ * Each block's time stamp is compared with the end of the previous block.
+ * A short gap is filled by repeating the last pitch period of the signal
+ * with a fade out, and the first samples of the next real block are
+ * crossfaded with the synthetic waveform. A gap too long to conceal is left
+ * as it is and the stream fades back in. The pitch search is bounded so a
+ * gap costs a fixed, small amount of CPU.
+ */
+class AudioConcealer
+{
+public:
+	AudioConcealer();
+	~AudioConcealer();
+
+	// Returns the block to play: data itself, or the caller's concealed
+	// buffer holding the concealed samples followed by the block. The
+	// stream has a single producer, which passes its blocks in order.
+	// outTimestamp is the time stamp of the first returned sample.
+	const short*	process(const short *data, int samples, long long timestamp, std::vector<short> &concealed,
+							int *outSamples, long long *outTimestamp);
+	void			reset();
+
+	void			getStats(NaoAudioStats &stats) const;
+
+private:
+	int		estimatePeriod() const;
+	void	synthesize(short *out, int samples, int period) const;
+	void	appendHistory(const short *data, int samples);
+
+private:
+	mutable pthread_mutex_t		m_mutex;
+	long long					m_expectedTimestamp;	// end of the previous block, 0 if none
+	std::vector<short>			m_history;				// newest samples, oldest first
+	int							m_historyFill;
+	std::vector<short>			m_synthetic;
+	NaoAudioStats				m_stats;
+};
+
+#endif // AUDIO_CONCEALER_H
@@ -110,9 +110,11 @@ void AudioCaptureRemote::process(const int &pNbOfInputChannels,
                               const AL_SOUND_FORMAT *pData,
                               const AL::ALValue &pTimeStamp)
 {
-  if (NaoInterface::instance() && NaoInterface::instance()->getAudioInterface()) 
+  // pTimeStamp is [seconds, microseconds] of the first sample
+  long long timestamp = (long long)(int) pTimeStamp[0] * 1000000 + (int) pTimeStamp[1];
+  if (NaoInterface::instance())
   {
-    NaoInterface::instance()->getAudioInterface()->writeData(pData, pNbrSamples);
+    NaoInterface::instance()->audioReceived(pData, pNbrSamples, timestamp);
   }
 }
 
@@ -0,0 +1,289 @@
+/**
+ * Multi-threaded post processing chain for preview frames
+ * Created 2026/10/19
+ */
+
+#include "filter_pipeline.h"
+#include "frame_filter.h"
+#include "nao_time.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+static const int MAX_WORKERS = 8;
+static const int MIN_TILE_ROWS = 16;
+
+FilterPipeline::FilterPipeline() : m_quit(false), m_outputSequence(0), m_nextSequence(0)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_cond, NULL);
+
+	m_filters[NAO_FILTER_DENOISE] = new DenoiseFilter();
+	m_filters[NAO_FILTER_WHITE_BALANCE] = new WhiteBalanceFilter();
+	m_filters[NAO_FILTER_GAMMA] = new GammaFilter(1.5);
+	m_filters[NAO_FILTER_SHARPEN] = new SharpenFilter();
+	for (int i = 0; i < NAO_FILTER_COUNT; i++)
+	{
+		m_enabled[i] = false;
+		m_averageUSecs[i] = 0;
+		m_runs[i] = 0;
+		m_skipped[i] = 0;
+	}
+	for (int i = 0; i < PIPELINE_DEPTH; i++)
+	{
+		m_jobs[i].busy = false;
+		m_jobs[i].stageCount = 0;
+	}
+
+	// leave one core to the GUI / NAOqi threads
+	int workers = (int) sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	workers = std::max(1, std::min(workers, MAX_WORKERS));
+	for (int i = 0; i < workers; i++)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, workerEntry, this) == 0)
+			m_threads.push_back(thread);
+	}
+}
+
+FilterPipeline::~FilterPipeline()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_quit = true;
+	pthread_cond_broadcast(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+
+	for (size_t i = 0; i < m_threads.size(); i++)
+		pthread_join(m_threads[i], NULL);
+
+	for (int i = 0; i < NAO_FILTER_COUNT; i++)
+		delete m_filters[i];
+
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void FilterPipeline::setEnabled(int filter, bool enabled)
+{
+	if (filter < 0 || filter >= NAO_FILTER_COUNT)
+		return;
+
+	pthread_mutex_lock(&m_mutex);
+	m_enabled[filter] = enabled;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+bool FilterPipeline::isActive() const
+{
+	bool active = false;
+	pthread_mutex_lock(&m_mutex);
+	for (int i = 0; i < NAO_FILTER_COUNT; i++)
+		active = active || m_enabled[i];
+	pthread_mutex_unlock(&m_mutex);
+	return active;
+}
+
+void FilterPipeline::getStats(int filter, NaoFilterStats &stats) const
+{
+	stats.enabled = false;
+	stats.averageUSecs = 0;
+	stats.runs = 0;
+	stats.skipped = 0;
+	if (filter < 0 || filter >= NAO_FILTER_COUNT)
+		return;
+
+	pthread_mutex_lock(&m_mutex);
+	stats.enabled = m_enabled[filter];
+	stats.averageUSecs = m_averageUSecs[filter];
+	stats.runs = m_runs[filter];
+	stats.skipped = m_skipped[filter];
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void FilterPipeline::submit(const cv::Mat &frame, int frameIntervalUSecs)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	FrameJob *job = NULL;
+	int inFlight = 0;
+	for (int i = 0; i < PIPELINE_DEPTH; i++)
+	{
+		if (m_jobs[i].busy)
+			inFlight++;
+		else if (job == NULL)
+			job = &m_jobs[i];
+	}
+	if (job == NULL)
+	{
+		// every slot is busy, the frame is dropped
+		for (int i = 0; i < NAO_FILTER_COUNT; i++)
+		{
+			if (m_enabled[i])
+				m_skipped[i]++;
+		}
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+
+	// Plan the stages. The chain is behind when its CPU cost spread over the
+	// workers does not fit in a capture interval, or when the pipeline is
+	// already nearly full.
+	bool use[NAO_FILTER_COUNT];
+	long long cost = 0;
+	for (int i = 0; i < NAO_FILTER_COUNT; i++)
+	{
+		use[i] = m_enabled[i];
+		if (use[i])
+			cost += m_averageUSecs[i];
+	}
+	int workers = std::max<int>(1, (int) m_threads.size());
+	bool behind = inFlight >= PIPELINE_DEPTH - 1;
+	while (behind || cost / workers > frameIntervalUSecs)
+	{
+		int costliest = -1;
+		for (int i = 0; i < NAO_FILTER_COUNT; i++)
+		{
+			if (use[i] && m_filters[i]->isSkippable() && (costliest < 0 || m_averageUSecs[i] > m_averageUSecs[costliest]))
+				costliest = i;
+		}
+		if (costliest < 0)
+			break;
+		use[costliest] = false;
+		cost -= m_averageUSecs[costliest];
+		m_skipped[costliest]++;
+		// let the estimate of a skipped stage decay so it gets retried
+		m_averageUSecs[costliest] -= m_averageUSecs[costliest] / 16;
+		behind = false;
+	}
+
+	job->busy = true;
+	job->sequence = ++m_nextSequence;
+	job->stageCount = 0;
+	for (int i = 0; i < NAO_FILTER_COUNT; i++)
+	{
+		if (use[i])
+			job->stages[job->stageCount++] = i;
+	}
+	job->stage = 0;
+	pthread_mutex_unlock(&m_mutex);
+
+	// The job is ours until its first tiles are queued.
+	frame.copyTo(job->buffers[0]);
+	job->buffers[1].create(frame.size(), frame.type());
+	job->current = 0;
+
+	int bands = std::max(1, std::min(workers * 2, frame.rows / MIN_TILE_ROWS));
+	int bandRows = (frame.rows + bands - 1) / bands;
+	job->tiles.clear();
+	for (int y = 0; y < frame.rows; y += bandRows)
+		job->tiles.push_back(cv::Rect(0, y, frame.cols, std::min(bandRows, frame.rows - y)));
+
+	if (job->stageCount == 0)
+	{
+		pthread_mutex_lock(&m_mutex);
+		publish(job);
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	beginStage(job, m_submitScratch);
+}
+
+bool FilterPipeline::fetch(cv::Mat &out)
+{
+	pthread_mutex_lock(&m_mutex);
+	bool available = m_outputSequence > 0;
+	if (available)
+		m_output.copyTo(out);
+	pthread_mutex_unlock(&m_mutex);
+	return available;
+}
+
+// Called without the mutex, by the thread that owns the job between stages.
+void FilterPipeline::beginStage(FrameJob *job, cv::Mat &scratch)
+{
+	const FrameFilter *filter = m_filters[job->stages[job->stage]];
+	job->params = cv::Scalar();
+	job->stageCostUSecs = 0;
+
+	long long start = getTimeUSecs();
+	filter->prepare(job->buffers[job->current], job->params, scratch);
+	job->stageCostUSecs += getTimeUSecs() - start;
+
+	pthread_mutex_lock(&m_mutex);
+	job->pendingTiles = (int) job->tiles.size();
+	for (int i = 0; i < (int) job->tiles.size(); i++)
+	{
+		TileTask task = { job, i };
+		m_tasks.push_back(task);
+	}
+	pthread_cond_broadcast(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+// Called with the mutex held.
+void FilterPipeline::publish(FrameJob *job)
+{
+	// An older frame finishing late must not replace a newer one.
+	if (job->sequence > m_outputSequence)
+	{
+		job->buffers[job->current].copyTo(m_output);
+		m_outputSequence = job->sequence;
+	}
+	job->busy = false;
+}
+
+//static
+void* FilterPipeline::workerEntry(void *arg)
+{
+	static_cast<FilterPipeline*>(arg)->workerLoop();
+	return NULL;
+}
+
+void FilterPipeline::workerLoop()
+{
+	cv::Mat scratch;
+
+	pthread_mutex_lock(&m_mutex);
+	while (!m_quit)
+	{
+		if (m_tasks.empty())
+		{
+			pthread_cond_wait(&m_cond, &m_mutex);
+			continue;
+		}
+
+		TileTask task = m_tasks.front();
+		m_tasks.pop_front();
+		FrameJob *job = task.job;
+		pthread_mutex_unlock(&m_mutex);
+
+		int filter = job->stages[job->stage];
+		long long start = getTimeUSecs();
+		m_filters[filter]->apply(job->buffers[job->current], job->buffers[1 - job->current],
+								 job->tiles[task.tile], job->params, scratch);
+		long long elapsed = getTimeUSecs() - start;
+
+		pthread_mutex_lock(&m_mutex);
+		job->stageCostUSecs += elapsed;
+		if (--job->pendingTiles > 0)
+			continue;
+
+		// last tile of the stage: account its cost and move the frame on
+		m_runs[filter]++;
+		m_averageUSecs[filter] = m_runs[filter] == 1 ? (int) job->stageCostUSecs
+							   : (int)((m_averageUSecs[filter] * 7 + job->stageCostUSecs) / 8);
+		job->current = 1 - job->current;
+		job->stage++;
+		if (job->stage < job->stageCount)
+		{
+			pthread_mutex_unlock(&m_mutex);
+			beginStage(job, scratch);
+			pthread_mutex_lock(&m_mutex);
+		}
+		else
+		{
+			publish(job);
+		}
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
@@ -0,0 +1,92 @@
+/**
+ * Multi-threaded post processing chain for preview frames
+ * Created 2026/10/19
+ */
+
+#ifndef FILTER_PIPELINE_H
+#define FILTER_PIPELINE_H
+
+#include <deque>
+#include <vector>
+#include <pthread.h>
+#include <opencv2/core/core.hpp>
+
+#include "nao_interface.h"
+
+class FrameFilter;
+
+/**
+ * Runs the enabled frame filters (in NaoFrameFilter order) on a pool of
+ * worker threads. Each frame is split into horizontal tiles; a stage starts
+ * once every tile of the previous stage is done, and tiles of consecutive
+ * frames share the same queue, so up to PIPELINE_DEPTH frames are in flight
+ * at different stages. When the measured cost of the chain exceeds the
+ * capture interval, skippable stages are left out, most expensive first.
+ */
+class FilterPipeline
+{
+public:
+	FilterPipeline();
+	~FilterPipeline();
+
+	void	setEnabled(int filter, bool enabled);
+	bool	isActive() const;
+
+	// Queues a copy of frame (8 bit, 3 channels).
+	void	submit(const cv::Mat &frame, int frameIntervalUSecs);
+	// Copies the newest finished frame into out, false until there is one.
+	bool	fetch(cv::Mat &out);
+
+	void	getStats(int filter, NaoFilterStats &stats) const;
+
+private:
+	enum { PIPELINE_DEPTH = 3 };
+
+	struct FrameJob
+	{
+		bool					busy;
+		long long				sequence;
+		cv::Mat					buffers[2];
+		int						current;
+		int						stages[NAO_FILTER_COUNT];
+		int						stageCount;
+		int						stage;
+		int						pendingTiles;
+		long long				stageCostUSecs;
+		cv::Scalar				params;
+		std::vector<cv::Rect>	tiles;
+	};
+
+	struct TileTask
+	{
+		FrameJob	*job;
+		int			tile;
+	};
+
+	static void*	workerEntry(void *arg);
+	void			workerLoop();
+	void			beginStage(FrameJob *job, cv::Mat &scratch);
+	void			publish(FrameJob *job);
+
+private:
+	mutable pthread_mutex_t	m_mutex;
+	pthread_cond_t			m_cond;
+	std::vector<pthread_t>	m_threads;
+	bool					m_quit;
+
+	std::deque<TileTask>	m_tasks;
+	FrameJob				m_jobs[PIPELINE_DEPTH];
+	cv::Mat					m_submitScratch;
+
+	FrameFilter				*m_filters[NAO_FILTER_COUNT];
+	bool					m_enabled[NAO_FILTER_COUNT];
+	int						m_averageUSecs[NAO_FILTER_COUNT];
+	long long				m_runs[NAO_FILTER_COUNT];
+	long long				m_skipped[NAO_FILTER_COUNT];
+
+	cv::Mat					m_output;
+	long long				m_outputSequence;
+	long long				m_nextSequence;
+};
+
+#endif // FILTER_PIPELINE_H
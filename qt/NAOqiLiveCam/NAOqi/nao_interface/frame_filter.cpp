@@ -0,0 +1,66 @@
+/**
+ * Post processing stages: denoise, white balance, gamma, sharpen
+ * Created 2026/10/19
+ */
+
+#include "frame_filter.h"
+
+#include <cmath>
+#include <algorithm>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// OpenCV filters working on a ROI header take the pixels around the ROI
+// from the parent image, so tiles need no explicit overlap.
+
+void DenoiseFilter::apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const
+{
+	(void)params;
+	(void)scratch;
+	cv::Mat out = dst(tile);
+	cv::bilateralFilter(src(tile), out, 5, 30.0, 5.0);
+}
+
+void WhiteBalanceFilter::prepare(const cv::Mat &frame, cv::Scalar &params, cv::Mat &scratch) const
+{
+	// Sample every 4th row and column, plenty for a global average.
+	cv::resize(frame, scratch, cv::Size(), 0.25, 0.25, cv::INTER_NEAREST);
+	cv::Scalar mean = cv::mean(scratch);
+	double gray = (mean[0] + mean[1] + mean[2]) / 3.0;
+	for (int i = 0; i < 3; i++)
+	{
+		params[i] = mean[i] > 1.0 ? std::min(gray / mean[i], 4.0) : 1.0;
+	}
+}
+
+void WhiteBalanceFilter::apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const
+{
+	(void)scratch;
+	cv::Mat out = dst(tile);
+	cv::multiply(src(tile), params, out);
+}
+
+GammaFilter::GammaFilter(double gamma) : FrameFilter("gamma", false)
+{
+	m_lut.create(1, 256, CV_8U);
+	for (int i = 0; i < 256; i++)
+	{
+		m_lut.at<uchar>(i) = cv::saturate_cast<uchar>(std::pow(i / 255.0, 1.0 / gamma) * 255.0);
+	}
+}
+
+void GammaFilter::apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const
+{
+	(void)params;
+	(void)scratch;
+	cv::Mat out = dst(tile);
+	cv::LUT(src(tile), m_lut, out);
+}
+
+void SharpenFilter::apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const
+{
+	(void)params;
+	// scratch belongs to the calling worker and keeps its allocation
+	cv::GaussianBlur(src(tile), scratch, cv::Size(0, 0), 2.0);
+	cv::Mat out = dst(tile);
+	cv::addWeighted(src(tile), 1.5, scratch, -0.5, 0, out);
+}
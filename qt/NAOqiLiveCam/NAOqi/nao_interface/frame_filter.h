@@ -0,0 +1,73 @@
+/**
+ * Post processing stages: denoise, white balance, gamma, sharpen
+ * Created 2026/10/19
+ */
+
+#ifndef FRAME_FILTER_H
+#define FRAME_FILTER_H
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * One stage of the post processing chain. prepare() runs once per frame on
+ * the whole image (for global statistics), apply() then runs concurrently
+ * on tiles. src and dst are full frames; filters read neighbours across the
+ * tile border from src and only write the tile into dst.
+ * Consecutive frames go through the same filter at the same time, so
+ * per frame state lives in params and temporaries in the worker's scratch.
+ */
+class FrameFilter
+{
+public:
+	FrameFilter(const char *name, bool skippable) : m_name(name), m_skippable(skippable) {}
+	virtual ~FrameFilter() {}
+
+	const char*	name() const { return m_name; }
+	// Whether the chain may leave this stage out when running behind.
+	bool		isSkippable() const { return m_skippable; }
+
+	virtual void prepare(const cv::Mat &frame, cv::Scalar &params, cv::Mat &scratch) const { (void)frame; (void)params; (void)scratch; }
+	virtual void apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const = 0;
+
+private:
+	const char	*m_name;
+	bool		m_skippable;
+};
+
+// Edge preserving noise reduction (bilateral filter)
+class DenoiseFilter : public FrameFilter
+{
+public:
+	DenoiseFilter() : FrameFilter("denoise", true) {}
+	virtual void apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const;
+};
+
+// Gray world white balance, gains computed on the whole frame
+class WhiteBalanceFilter : public FrameFilter
+{
+public:
+	WhiteBalanceFilter() : FrameFilter("white balance", false) {}
+	virtual void prepare(const cv::Mat &frame, cv::Scalar &params, cv::Mat &scratch) const;
+	virtual void apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const;
+};
+
+// Gamma correction through a lookup table
+class GammaFilter : public FrameFilter
+{
+public:
+	GammaFilter(double gamma);
+	virtual void apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const;
+
+private:
+	cv::Mat		m_lut;
+};
+
+// Unsharp mask
+class SharpenFilter : public FrameFilter
+{
+public:
+	SharpenFilter() : FrameFilter("sharpen", true) {}
+	virtual void apply(const cv::Mat &src, cv::Mat &dst, const cv::Rect &tile, const cv::Scalar &params, cv::Mat &scratch) const;
+};
+
+#endif // FRAME_FILTER_H
@@ -0,0 +1,335 @@
+/**
+ * Head pan / tilt control loop and the motion services it drives
+ * Created 2026/10/19
+ */
+
+#include "head_controller.h"
+#include "nao_time.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <alproxies/almotionproxy.h>
+#include <alerror/alerror.h>
+
+static const int CONTROL_PERIOD_USECS = 50000;		// 20 Hz
+static const float MAX_SPEED_FRACTION = 0.5f;
+static const float MOTION_THRESHOLD = 0.01f;		// rad the head must move to count as responding
+
+// joint limits from the NAO H25 documentation
+static const float HEAD_YAW_MIN = -2.0857f;
+static const float HEAD_YAW_MAX = 2.0857f;
+static const float HEAD_PITCH_MIN = -0.6720f;
+static const float HEAD_PITCH_MAX = 0.5149f;
+
+// stand-in motion service
+static const int SIM_ROUND_TRIP_USECS = 5000;
+static const int SIM_ACTUATION_USECS = 40000;
+static const float SIM_SPEED = 4.0f;				// rad/s
+
+static float distance(float yaw0, float pitch0, float yaw1, float pitch1)
+{
+	return std::max(std::fabs(yaw0 - yaw1), std::fabs(pitch0 - pitch1));
+}
+
+static float approach(float from, float to, float step)
+{
+	if (from < to)
+		return std::min(from + step, to);
+	return std::max(from - step, to);
+}
+
+ALHeadMotion::ALHeadMotion(AL::ALMotionProxy *proxy) : m_proxy(proxy), m_stiff(false)
+{
+}
+
+ALHeadMotion::~ALHeadMotion()
+{
+	// hand the head back as it was: released if nobody else held it, still
+	// stiff if a behavior on the robot had stiffened it
+	if (!m_stiff || m_savedStiffness.size() < 2)
+		return;
+	try
+	{
+		AL::ALValue names = AL::ALValue::array("HeadYaw", "HeadPitch");
+		AL::ALValue stiffnesses = AL::ALValue::array(m_savedStiffness[0], m_savedStiffness[1]);
+		m_proxy->setStiffnesses(names, stiffnesses);
+	}
+	catch( AL::ALError e)
+	{
+		std::cerr << "Cannot restore head stiffness: " << e.what() << std::endl;
+	}
+}
+
+void ALHeadMotion::setTarget(float yaw, float pitch)
+{
+	if (!m_stiff)
+	{
+		m_savedStiffness = m_proxy->getStiffnesses("Head");
+		m_proxy->setStiffnesses("Head", 1.0f);
+		m_stiff = true;
+	}
+
+	AL::ALValue names = AL::ALValue::array("HeadYaw", "HeadPitch");
+	AL::ALValue angles = AL::ALValue::array(yaw, pitch);
+	// setAngles returns without waiting for the motion; a newer call
+	// replaces the running interpolation
+	m_proxy->setAngles(names, angles, MAX_SPEED_FRACTION);
+}
+
+bool ALHeadMotion::getAngles(float *yaw, float *pitch)
+{
+	try
+	{
+		std::vector<float> angles = m_proxy->getAngles("Head", true);
+		if (angles.size() < 2)
+			return false;
+		*yaw = angles[0];
+		*pitch = angles[1];
+		return true;
+	}
+	catch( AL::ALError e)
+	{
+		std::cerr << "Cannot read head angles: " << e.what() << std::endl;
+	}
+	return false;
+}
+
+SimulatedHeadMotion::SimulatedHeadMotion()
+	: m_yaw(0.0f)
+	, m_pitch(0.0f)
+	, m_targetYaw(0.0f)
+	, m_targetPitch(0.0f)
+	, m_nextYaw(0.0f)
+	, m_nextPitch(0.0f)
+	, m_nextTime(0)
+	, m_lastUpdate(getTimeUSecs())
+{
+	pthread_mutex_init(&m_mutex, NULL);
+}
+
+SimulatedHeadMotion::~SimulatedHeadMotion()
+{
+	pthread_mutex_destroy(&m_mutex);
+}
+
+// Called with the mutex held.
+void SimulatedHeadMotion::advance(long long now)
+{
+	if (m_nextTime > 0 && now >= m_nextTime)
+	{
+		float step = SIM_SPEED * (m_nextTime - m_lastUpdate) / 1000000.0f;
+		m_yaw = approach(m_yaw, m_targetYaw, step);
+		m_pitch = approach(m_pitch, m_targetPitch, step);
+		m_targetYaw = m_nextYaw;
+		m_targetPitch = m_nextPitch;
+		m_lastUpdate = m_nextTime;
+		m_nextTime = 0;
+	}
+	float step = SIM_SPEED * (now - m_lastUpdate) / 1000000.0f;
+	m_yaw = approach(m_yaw, m_targetYaw, step);
+	m_pitch = approach(m_pitch, m_targetPitch, step);
+	m_lastUpdate = now;
+}
+
+void SimulatedHeadMotion::setTarget(float yaw, float pitch)
+{
+	usleep(SIM_ROUND_TRIP_USECS);
+
+	pthread_mutex_lock(&m_mutex);
+	long long now = getTimeUSecs();
+	advance(now);
+	m_nextYaw = yaw;
+	m_nextPitch = pitch;
+	m_nextTime = now + SIM_ACTUATION_USECS;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+bool SimulatedHeadMotion::getAngles(float *yaw, float *pitch)
+{
+	usleep(SIM_ROUND_TRIP_USECS);
+
+	pthread_mutex_lock(&m_mutex);
+	advance(getTimeUSecs());
+	*yaw = m_yaw;
+	*pitch = m_pitch;
+	pthread_mutex_unlock(&m_mutex);
+	return true;
+}
+
+HeadController::HeadController(HeadMotion *motion)
+	: m_motion(motion)
+	, m_running(false)
+	, m_quit(false)
+	, m_targetYaw(0.0f)
+	, m_targetPitch(0.0f)
+	, m_targetTime(0)
+	, m_hasPending(false)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_cond, NULL);
+	m_stats.requested = 0;
+	m_stats.sent = 0;
+	m_stats.coalesced = 0;
+	m_stats.failed = 0;
+	m_stats.lastLatencyUSecs = 0;
+	m_stats.averageLatencyUSecs = 0;
+
+	m_running = pthread_create(&m_thread, NULL, controlEntry, this) == 0;
+}
+
+HeadController::~HeadController()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_quit = true;
+	pthread_cond_broadcast(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+
+	if (m_running)
+		pthread_join(m_thread, NULL);
+	delete m_motion;
+
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void HeadController::setTarget(float yaw, float pitch)
+{
+	pthread_mutex_lock(&m_mutex);
+	m_stats.requested++;
+	if (m_hasPending)
+		m_stats.coalesced++;
+	m_targetYaw = std::max(HEAD_YAW_MIN, std::min(yaw, HEAD_YAW_MAX));
+	m_targetPitch = std::max(HEAD_PITCH_MIN, std::min(pitch, HEAD_PITCH_MAX));
+	m_targetTime = getTimeUSecs();
+	m_hasPending = true;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void HeadController::getTarget(float *yaw, float *pitch) const
+{
+	pthread_mutex_lock(&m_mutex);
+	*yaw = m_targetYaw;
+	*pitch = m_targetPitch;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void HeadController::getStats(NaoHeadStats &stats) const
+{
+	pthread_mutex_lock(&m_mutex);
+	stats = m_stats;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+//static
+void* HeadController::controlEntry(void *arg)
+{
+	static_cast<HeadController*>(arg)->controlLoop();
+	return NULL;
+}
+
+void HeadController::controlLoop()
+{
+	// targets are relative to where the head is when control starts
+	float yaw = 0.0f;
+	float pitch = 0.0f;
+	if (m_motion->getAngles(&yaw, &pitch))
+	{
+		pthread_mutex_lock(&m_mutex);
+		if (!m_hasPending)
+		{
+			m_targetYaw = yaw;
+			m_targetPitch = pitch;
+		}
+		pthread_mutex_unlock(&m_mutex);
+	}
+
+	// command being measured: the head has responded once it moved
+	// MOTION_THRESHOLD closer to the target
+	bool measuring = false;
+	long long commandTime = 0;
+	float commandYaw = 0.0f;
+	float commandPitch = 0.0f;
+	float startDistance = 0.0f;
+
+	long long nextTick = getTimeUSecs();
+	pthread_mutex_lock(&m_mutex);
+	while (!m_quit)
+	{
+		nextTick += CONTROL_PERIOD_USECS;
+		struct timespec deadline;
+		deadline.tv_sec = nextTick / 1000000;
+		deadline.tv_nsec = (nextTick % 1000000) * 1000;
+		while (!m_quit && pthread_cond_timedwait(&m_cond, &m_mutex, &deadline) != ETIMEDOUT)
+			;
+		if (m_quit)
+			break;
+
+		bool send = m_hasPending;
+		float targetYaw = m_targetYaw;
+		float targetPitch = m_targetPitch;
+		long long targetTime = m_targetTime;
+		m_hasPending = false;
+		pthread_mutex_unlock(&m_mutex);
+
+		bool failed = false;
+		int latency = -1;
+		if (send)
+		{
+			try
+			{
+				m_motion->setTarget(targetYaw, targetPitch);
+			}
+			catch( const std::exception &e)
+			{
+				std::cerr << "Cannot move head: " << e.what() << std::endl;
+				failed = true;
+			}
+		}
+
+		// during a drag a command goes out every tick; the measurement
+		// stays on the oldest command not answered yet
+		if (send && !failed && !measuring)
+		{
+			measuring = m_motion->getAngles(&yaw, &pitch);
+			commandTime = targetTime;
+			commandYaw = targetYaw;
+			commandPitch = targetPitch;
+			startDistance = distance(yaw, pitch, commandYaw, commandPitch);
+			measuring = measuring && startDistance > MOTION_THRESHOLD;
+		}
+		else if (measuring && m_motion->getAngles(&yaw, &pitch))
+		{
+			if (startDistance - distance(yaw, pitch, commandYaw, commandPitch) > MOTION_THRESHOLD)
+			{
+				latency = (int)(getTimeUSecs() - commandTime);
+				measuring = false;
+			}
+		}
+
+		// round trips may have eaten into the next ticks; never catch up
+		// with a burst of commands
+		long long now = getTimeUSecs();
+		if (nextTick < now - CONTROL_PERIOD_USECS)
+			nextTick = now;
+
+		pthread_mutex_lock(&m_mutex);
+		if (send)
+		{
+			if (failed)
+				m_stats.failed++;
+			else
+				m_stats.sent++;
+		}
+		if (latency >= 0)
+		{
+			m_stats.averageLatencyUSecs = m_stats.lastLatencyUSecs == 0 ? latency
+										: (m_stats.averageLatencyUSecs * 7 + latency) / 8;
+			m_stats.lastLatencyUSecs = latency;
+		}
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
@@ -0,0 +1,112 @@
+/**
+ * Head pan / tilt control loop and the motion services it drives
+ * Created 2026/10/19
+ */
+
+#ifndef HEAD_CONTROLLER_H
+#define HEAD_CONTROLLER_H
+
+#include <vector>
+#include <pthread.h>
+
+#include "nao_interface.h"
+
+namespace AL
+{
+	class ALMotionProxy;
+}
+
+/**
+ * Motion service driving the head. setTarget() must not wait for the
+ * motion itself.
+ */
+class HeadMotion
+{
+public:
+	virtual ~HeadMotion() {}
+	virtual void	setTarget(float yaw, float pitch) = 0;
+	virtual bool	getAngles(float *yaw, float *pitch) = 0;
+};
+
+// HeadYaw / HeadPitch through ALMotion
+class ALHeadMotion : public HeadMotion
+{
+public:
+	ALHeadMotion(AL::ALMotionProxy *proxy);
+	~ALHeadMotion();		// restores the head stiffness, the proxy must still exist
+
+	virtual void	setTarget(float yaw, float pitch);
+	virtual bool	getAngles(float *yaw, float *pitch);
+
+private:
+	AL::ALMotionProxy	*m_proxy;
+	bool				m_stiff;
+	std::vector<float>	m_savedStiffness;	// HeadYaw, HeadPitch before the first command
+};
+
+/**
+ * Local stand-in for ALMotion: every call costs a fixed round trip and the
+ * head starts moving a fixed actuation delay after a command, at constant
+ * speed. Used to measure the control path without a robot.
+ */
+class SimulatedHeadMotion : public HeadMotion
+{
+public:
+	SimulatedHeadMotion();
+	~SimulatedHeadMotion();
+
+	virtual void	setTarget(float yaw, float pitch);
+	virtual bool	getAngles(float *yaw, float *pitch);
+
+private:
+	void	advance(long long now);
+
+private:
+	pthread_mutex_t		m_mutex;
+	float				m_yaw;
+	float				m_pitch;
+	float				m_targetYaw;
+	float				m_targetPitch;
+	float				m_nextYaw;
+	float				m_nextPitch;
+	long long			m_nextTime;		// when the next target takes effect, 0 if none
+	long long			m_lastUpdate;
+};
+
+/**
+ * Head pan / tilt control loop on its own thread. setTarget() only stores
+ * the newest target; once per control tick the loop sends it if it changed,
+ * so a burst of drag events turns into at most one command per tick and no
+ * stale commands queue up. While a command is outstanding the loop reads
+ * the joint angles back to measure when the head starts to move.
+ */
+class HeadController
+{
+public:
+	HeadController(HeadMotion *motion);		// takes ownership
+	~HeadController();
+
+	void	setTarget(float yaw, float pitch);
+	void	getTarget(float *yaw, float *pitch) const;
+	void	getStats(NaoHeadStats &stats) const;
+
+private:
+	static void*	controlEntry(void *arg);
+	void			controlLoop();
+
+private:
+	HeadMotion					*m_motion;
+	mutable pthread_mutex_t		m_mutex;
+	pthread_cond_t				m_cond;
+	pthread_t					m_thread;
+	bool						m_running;
+	bool						m_quit;
+
+	float						m_targetYaw;
+	float						m_targetPitch;
+	long long					m_targetTime;	// operator input time of the target
+	bool						m_hasPending;
+	NaoHeadStats				m_stats;
+};
+
+#endif // HEAD_CONTROLLER_H
@@ -13,6 +13,12 @@
 #include <alcommon/almodule.h>
 #include <alcommon/albrokermanager.h>
 #include "audiocaptureremote.h"
+#include "filter_pipeline.h"
+#include "vision_analyzer.h"
+#include "replay_buffer.h"
+#include "head_controller.h"
+#include "audio_concealer.h"
+#include "nao_time.h"
 
 #ifdef AVCAPTURE_IS_REMOTE
 # define ALCALL
@@ -25,7 +31,11 @@
 #endif
 
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <vector>
 #include <alproxies/alvideodeviceproxy.h>
+#include <alproxies/almotionproxy.h>
 #include <alvision/alimage.h>
 #include <alvision/alvisiondefinitions.h>
 #include <alerror/alerror.h>
@@ -36,17 +46,59 @@
 
 static AL::ALVideoDeviceProxy	*s_cameraProxy = NULL;
 static AL::ALProxy 				*s_audioCaptureProxy = NULL;
+static AL::ALMotionProxy		*s_motionProxy = NULL;
+static HeadController			*s_headController = NULL;
+static bool						s_headSimulated = false;
 static std::string				s_cameraClientName;
 static cv::Mat					s_cameraImage;
 static cv::Mat					s_cameraImageClone;
+static AL::ALVideoDeviceProxy	*s_snapshotProxy = NULL;
+static std::string				s_snapshotClientName;
+static int						s_snapshotFrameRate = 0;
+static long long				s_snapshotTimestamp = 0;	// newest snapshot frame seen, 0 right after subscribing
+
+static int						s_cameraResolution = NAO_RES_QVGA;
+static int						s_cameraColorSpace = NAO_CS_RGB;
+static int						s_frameWidth = 0;
+static int						s_frameHeight = 0;
+static int						s_frameColorSpace = NAO_CS_RGB;
+static int						s_subscribedResolution = NAO_RES_QVGA;
+static bool						s_roiEnabled = false;
+static float					s_roiX = 0.0f;
+static float					s_roiY = 0.0f;
+static float					s_roiWidth = 1.0f;
+static float					s_roiHeight = 1.0f;
+static int						s_roiMaxWidth = 0;
+static NaoStreamStats			s_streamStats = {0, 0, 0, 0, 0, 0};
+static int						s_cameraFrameRate = CAMERA_FPS;
+static FilterPipeline			*s_filterPipeline = NULL;
+static cv::Mat					s_filteredImage;
+static VisionAnalyzer			*s_visionAnalyzer = NULL;
+static long long				s_frameTimestamp = 0;
+static ReplayBuffer				s_replayBuffer;
+static AudioConcealer			s_audioConcealer;
+static int						s_consumerDemand[NAO_CONSUMER_COUNT] = {NAO_DEMAND_FULL, NAO_DEMAND_NONE, NAO_DEMAND_NONE};
+static int						s_demand = NAO_DEMAND_FULL;
+static int						s_subscribedFrameRate = CAMERA_FPS;
+static NaoDemandStats			s_demandStats = {0, 0, 0, 0, 0};
+static long long				s_demandPeriodStart = 0;
+static long long				s_demandPeriodFrames = 0;
+static long long				s_demandPeriodWireBytes = 0;
+static int						s_fullFrameBytes = 0;
+static long long				s_frameCpuUSecs = 0;		// capture thread CPU spent in updateCameraView()
+static int						s_fullFrameCpuUSecs = 0;	// average per frame at full demand
+static long long				s_demandPeriodCpuUSecs = 0;
+
+static const int SNAPSHOT_MIN_FPS = 2;					// snapshot rate for a single frame
+static const long long SNAPSHOT_TIMEOUT_USECS = 500000;	// extra wait for a new snapshot frame
 
 static std::string s_robotIpAddress = "";
+static boost::shared_ptr<AL::ALBroker> s_broker;
 
 static pthread_mutex_t	s_mutex;
 static pthread_mutex_t	s_mutexCamUpdate;
-
-const static float	QVGA_WIDTH	= 320;
-const static float	QVGA_HEIGHT	= 240;
+static pthread_mutex_t	s_mutexSnapshot;
+static pthread_mutex_t	s_mutexHead;
 
 class ThreadLockHelper
 {
@@ -65,6 +117,14 @@ public:
 
 #define LOCKER(mutex) ThreadLockHelper __locker(mutex);((void)__locker);
 
+static int toALResolution(int resolution);
+static int toALColorSpace(int colorSpace);
+static int fromALColorSpace(int alColorSpace);
+static int effectiveResolution();
+static int effectiveFrameRate();
+static void subscribeCamera();
+static void unsubscribeCamera();
+
 //static
 NaoInterface* NaoInterface::instance()
 {
@@ -77,19 +137,34 @@ NaoInterface::NaoInterface() : m_audioOutput(NULL)
 {
 	pthread_mutex_init(&s_mutex, NULL);
 	pthread_mutex_init(&s_mutexCamUpdate, NULL);
+	pthread_mutex_init(&s_mutexSnapshot, NULL);
+	pthread_mutex_init(&s_mutexHead, NULL);
 }
 
 NaoInterface::~NaoInterface()
 {
 	disconnect();
+
+	delete s_filterPipeline;
+	s_filterPipeline = NULL;
+
+	delete s_visionAnalyzer;
+	s_visionAnalyzer = NULL;
+
+	delete s_headController;
+	s_headController = NULL;
 }
 
 void NaoInterface::setNaoIp(const std::string ipAddress)
 {
-	static boost::shared_ptr<AL::ALBroker> broker;
-
 	if (s_robotIpAddress != ipAddress)
 	{
+		// The broker and everything created on it belong to one connection.
+		// Tear the previous one down first: disconnect() kills every broker.
+		if (s_broker)
+		{
+			disconnect();
+		}
 
 		int parentBrokerPort = 9559;
 
@@ -104,7 +179,7 @@ void NaoInterface::setNaoIp(const std::string ipAddress)
 
 		try
 		{
-			broker = AL::ALBroker::createBroker(
+			s_broker = AL::ALBroker::createBroker(
 				brokerName,
 				brokerIp,
 				brokerPort,
@@ -121,38 +196,45 @@ void NaoInterface::setNaoIp(const std::string ipAddress)
 			<< ":"
 			<< parentBrokerPort
 			<< std::endl;
+			s_broker.reset();
 			AL::ALBrokerManager::getInstance()->killAllBroker();
 			AL::ALBrokerManager::kill();
-			return;
+			throw std::string("Cannot connect to ") + ipAddress;
 		}
 
 		// Deal with ALBrokerManager singleton:
-		AL::ALBrokerManager::setInstance(broker->fBrokerManager.lock());
-		AL::ALBrokerManager::getInstance()->addBroker(broker);
+		AL::ALBrokerManager::setInstance(s_broker->fBrokerManager.lock());
+		AL::ALBrokerManager::getInstance()->addBroker(s_broker);
 
-
-		// Now it's time to load your module with
-		AL::ALModule::createModule<AudioCaptureRemote>(broker, "AudioCaptureRemote");
-
-		if (s_cameraProxy)
-		{
-			disconnect();
-		}
-		
         try
         {
+			// Now it's time to load your module with
+			AL::ALModule::createModule<AudioCaptureRemote>(s_broker, "AudioCaptureRemote");
+
 			s_cameraProxy = new AL::ALVideoDeviceProxy();
+			{
+				LOCKER(s_mutexSnapshot);
+				s_snapshotProxy = new AL::ALVideoDeviceProxy();
+			}
 
 			LOCKER(s_mutexCamUpdate);
-			s_cameraClientName = s_cameraProxy->subscribe("cam1", AL::kQVGA, AL::kRGBColorSpace, CAMERA_FPS);
-			s_cameraImage  = cv::Mat(cv::Size((int)QVGA_WIDTH, (int)QVGA_HEIGHT), CV_8UC3);
+			if (s_demand != NAO_DEMAND_NONE)
+				subscribeCamera();
 
-			s_audioCaptureProxy = new AL::ALProxy(broker,"AudioCaptureRemote");
+			s_audioCaptureProxy = new AL::ALProxy(s_broker,"AudioCaptureRemote");
 
+			{
+				LOCKER(s_mutexHead);
+				s_motionProxy = new AL::ALMotionProxy();
+				delete s_headController;
+				s_headController = new HeadController(new ALHeadMotion(s_motionProxy));
+			}
 		}
 		catch( AL::ALError e)
 		{
+			// release whatever was created before the failure
 			std::string msg = e.what();
+			disconnect();
 			throw msg;
 		}
 		s_robotIpAddress = ipAddress;
@@ -164,6 +246,13 @@ void NaoInterface::disconnect()
 {
 	LOCKER(s_mutex);
 
+	unsubscribeSnapshot();
+	{
+		LOCKER(s_mutexSnapshot);
+		delete s_snapshotProxy;
+		s_snapshotProxy = NULL;
+	}
+
 	if (s_cameraProxy)
 	{
 		try
@@ -191,11 +280,30 @@ void NaoInterface::disconnect()
 		catch( AL::ALError e)
 		{
 		}
+		delete s_audioCaptureProxy;
 	}
 	s_audioCaptureProxy = NULL;
 
-	AL::ALBrokerManager::getInstance()->killAllBroker();
-	AL::ALBrokerManager::kill();
+	{
+		// The controller releases the head stiffness through the motion
+		// proxy, so it goes first. setHeadSimulation() reads the proxy
+		// under the same lock.
+		LOCKER(s_mutexHead);
+		delete s_headController;
+		s_headController = s_headSimulated ? new HeadController(new SimulatedHeadMotion()) : NULL;
+		delete s_motionProxy;
+		s_motionProxy = NULL;
+	}
+
+	if (s_broker)
+	{
+		// the modules created on the broker go with it
+		AL::ALBrokerManager::getInstance()->killAllBroker();
+		AL::ALBrokerManager::kill();
+		s_broker.reset();
+	}
+	// the next stream starts without a gap
+	s_audioConcealer.reset();
 
 	s_robotIpAddress = "0.0.0.0";
 
@@ -212,9 +320,11 @@ unsigned char* NaoInterface::updateCameraView()
 {
 	LOCKER(s_mutexCamUpdate);
 
-	if (s_cameraProxy == NULL)
+	if (s_cameraProxy == NULL || s_cameraClientName.length() == 0)
 		return NULL;
 
+	long long cpuStart = getThreadCpuUSecs();
+
 	/** Retrieve an image from the camera.
 	 * The image is returned in the form of a container object, with the
 	 * following fields:
@@ -226,14 +336,651 @@ unsigned char* NaoInterface::updateCameraView()
 	 * 5 = time stamp (micro seconds)
 	 * 6 = image buffer (size of width * height * number of layers)
 	 */
+	long long requestTime = getTimeUSecs();
 	AL::ALValue img = s_cameraProxy->getImageRemote(s_cameraClientName);
+	int roundTrip = (int)(getTimeUSecs() - requestTime);
+	s_frameWidth = (int) img[0];
+	s_frameHeight = (int) img[1];
+	int layers = (int) img[2];
+	s_frameColorSpace = fromALColorSpace((int) img[3]);
+	s_frameTimestamp = (long long)(int) img[4] * 1000000 + (int) img[5];
+
 	/** Access the image buffer (6th field) and assign it to the opencv image
 		* container. */
-	s_cameraImage.data = (uchar*) img[6].GetBinary();
-	s_cameraImageClone = s_cameraImage.clone();
+	s_cameraImage = cv::Mat(s_frameHeight, s_frameWidth, CV_8UC(layers), (uchar*) img[6].GetBinary());
+	s_streamStats.frames++;
+	s_streamStats.wireBytes += s_frameWidth * s_frameHeight * layers;
+	s_streamStats.roundTripUSecs += roundTrip;
+	s_streamStats.lastRoundTripUSecs = roundTrip;
+	s_streamStats.lastFrameBytes = s_frameWidth * s_frameHeight * layers;
+	if (s_demand == NAO_DEMAND_FULL)
+		s_fullFrameBytes = s_streamStats.lastFrameBytes;
+
+	if (s_roiEnabled)
+	{
+		cv::Rect rect((int)(s_roiX * s_frameWidth), (int)(s_roiY * s_frameHeight),
+					  (int)(s_roiWidth * s_frameWidth), (int)(s_roiHeight * s_frameHeight));
+		if (s_frameColorSpace == NAO_CS_YUV422)
+		{
+			// keep Y0 U Y1 V pairs intact
+			rect.x &= ~1;
+			rect.width &= ~1;
+		}
+		rect &= cv::Rect(0, 0, s_frameWidth, s_frameHeight);
+		if (rect.width < 2 || rect.height < 2)
+			rect = cv::Rect(0, 0, s_frameWidth, s_frameHeight);
+
+		cv::Mat crop = s_cameraImage(rect);
+		if (s_roiMaxWidth > 0 && rect.width > s_roiMaxWidth && s_frameColorSpace != NAO_CS_YUV422)
+		{
+			// Hue must not be interpolated, everything else is averaged.
+			// The destination Mat is reused while the geometry stays the same.
+			cv::Size size(s_roiMaxWidth, rect.height * s_roiMaxWidth / rect.width);
+			cv::resize(crop, s_cameraImageClone, size, 0, 0, s_frameColorSpace == NAO_CS_HSY ? cv::INTER_NEAREST : cv::INTER_AREA);
+		}
+		else
+		{
+			crop.copyTo(s_cameraImageClone);
+		}
+		s_frameWidth = s_cameraImageClone.cols;
+		s_frameHeight = s_cameraImageClone.rows;
+	}
+	else
+	{
+		// copyTo() keeps the previous allocation while the geometry is unchanged
+		s_cameraImage.copyTo(s_cameraImageClone);
+	}
 	s_cameraProxy->releaseImage(s_cameraClientName);
+	s_streamStats.displayBytes += s_frameWidth * s_frameHeight * layers;
+
+	cv::Mat *output = &s_cameraImageClone;
+	if (s_filterPipeline && layers == 3 && s_frameColorSpace != NAO_CS_HSY && s_filterPipeline->isActive())
+	{
+		s_filterPipeline->submit(s_cameraImageClone, 1000000 / std::max(1, s_subscribedFrameRate));
+		if (s_filterPipeline->fetch(s_filteredImage))
+		{
+			s_frameWidth = s_filteredImage.cols;
+			s_frameHeight = s_filteredImage.rows;
+			output = &s_filteredImage;
+		}
+	}
+
+	if (s_visionAnalyzer)
+		s_visionAnalyzer->submit(*output, s_frameColorSpace, s_frameTimestamp);
 
-	return (unsigned char*) s_cameraImageClone.data;
+	s_replayBuffer.addFrame(*output, s_frameColorSpace, s_frameTimestamp);
+
+	// unpacking, copying and handing on the frame, not waiting for it
+	int cpu = (int)(getThreadCpuUSecs() - cpuStart);
+	s_frameCpuUSecs += cpu;
+	if (s_demand == NAO_DEMAND_FULL)
+		s_fullFrameCpuUSecs = s_fullFrameCpuUSecs > 0 ? (7 * s_fullFrameCpuUSecs + cpu) / 8 : cpu;
+
+	return (unsigned char*) output->data;
+}
+
+// Picks the subscription resolution: the requested one, capped while only
+// background consumers need frames. A region of interest does not raise it:
+// ALVideoDevice sends whole frames, so a higher resolution would multiply
+// the bytes on the link for every zoomed frame.
+static int effectiveResolution()
+{
+	if (s_demand == NAO_DEMAND_LOW)
+		return std::min(s_cameraResolution, (int) NAO_RES_QVGA);
+	return s_cameraResolution;
 }
 
+// must be called with s_mutexCamUpdate held
+static void applySubscriptionResolution()
+{
+	int resolution = effectiveResolution();
+	if (resolution == s_subscribedResolution)
+		return;
 
+	if (s_cameraProxy && s_cameraClientName.length() > 0)
+	{
+		try
+		{
+			s_cameraProxy->setResolution(s_cameraClientName, toALResolution(resolution));
+		}
+		catch( AL::ALError e)
+		{
+			std::cerr << "Cannot change camera resolution: " << e.what() << std::endl;
+			return;
+		}
+	}
+	s_subscribedResolution = resolution;
+}
+
+static int effectiveFrameRate()
+{
+	if (s_demand == NAO_DEMAND_LOW)
+		return std::min(s_cameraFrameRate, LOW_DEMAND_FPS);
+	return s_cameraFrameRate;
+}
+
+// must be called with s_mutexCamUpdate held
+static void applySubscriptionFrameRate()
+{
+	int fps = effectiveFrameRate();
+	if (fps == s_subscribedFrameRate)
+		return;
+
+	if (s_cameraProxy && s_cameraClientName.length() > 0)
+	{
+		try
+		{
+			s_cameraProxy->setFrameRate(s_cameraClientName, fps);
+		}
+		catch( AL::ALError e)
+		{
+			std::cerr << "Cannot change camera frame rate: " << e.what() << std::endl;
+			return;
+		}
+	}
+	s_subscribedFrameRate = fps;
+}
+
+// must be called with s_mutexCamUpdate held, throws AL::ALError
+static void subscribeCamera()
+{
+	s_subscribedResolution = effectiveResolution();
+	s_subscribedFrameRate = effectiveFrameRate();
+	s_cameraClientName = s_cameraProxy->subscribe("cam1", toALResolution(s_subscribedResolution), toALColorSpace(s_cameraColorSpace), s_subscribedFrameRate);
+}
+
+// must be called with s_mutexCamUpdate held
+static void unsubscribeCamera()
+{
+	try
+	{
+		if (s_cameraClientName.length() > 0)
+			s_cameraProxy->unsubscribe(s_cameraClientName);
+	}
+	catch( AL::ALError e)
+	{
+		std::cerr << "Cannot unsubscribe camera: " << e.what() << std::endl;
+	}
+	s_cameraClientName = "";
+}
+
+// Closes the current demand period: while below full demand, what full
+// demand would have pulled minus what was actually pulled is counted as
+// saved, and likewise for the capture thread CPU per frame. Must be called with s_mutexCamUpdate held.
+static void accountDemandPeriod()
+{
+	long long now = getTimeUSecs();
+	if (s_demand != NAO_DEMAND_FULL && s_demandPeriodStart > 0)
+	{
+		long long elapsed = now - s_demandPeriodStart;
+		long long expectedFrames = elapsed * s_cameraFrameRate / 1000000;
+		long long frames = s_streamStats.frames - s_demandPeriodFrames;
+		long long bytes = s_streamStats.wireBytes - s_demandPeriodWireBytes;
+		if (s_demand == NAO_DEMAND_NONE)
+			s_demandStats.pausedUSecs += elapsed;
+		else
+			s_demandStats.throttledUSecs += elapsed;
+		s_demandStats.savedFrames += std::max(0LL, expectedFrames - frames);
+		s_demandStats.savedBytes += std::max(0LL, expectedFrames * s_fullFrameBytes - bytes);
+		long long cpu = s_frameCpuUSecs - s_demandPeriodCpuUSecs;
+		s_demandStats.savedCpuUSecs += std::max(0LL, expectedFrames * s_fullFrameCpuUSecs - cpu);
+	}
+	s_demandPeriodStart = now;
+	s_demandPeriodFrames = s_streamStats.frames;
+	s_demandPeriodWireBytes = s_streamStats.wireBytes;
+	s_demandPeriodCpuUSecs = s_frameCpuUSecs;
+}
+
+void NaoInterface::setCameraResolution(int resolution)
+{
+	LOCKER(s_mutexCamUpdate);
+
+	s_cameraResolution = resolution;
+	applySubscriptionResolution();
+}
+
+void NaoInterface::setCameraColorSpace(int colorSpace)
+{
+	LOCKER(s_mutexCamUpdate);
+
+	if (colorSpace == s_cameraColorSpace)
+		return;
+
+	if (s_cameraProxy && s_cameraClientName.length() > 0)
+	{
+		try
+		{
+			s_cameraProxy->setColorSpace(s_cameraClientName, toALColorSpace(colorSpace));
+		}
+		catch( AL::ALError e)
+		{
+			std::cerr << "Cannot change camera color space: " << e.what() << std::endl;
+			return;
+		}
+	}
+	s_cameraColorSpace = colorSpace;
+}
+
+void NaoInterface::setCameraFrameRate(int fps)
+{
+	LOCKER(s_mutexCamUpdate);
+
+	accountDemandPeriod();
+	s_cameraFrameRate = fps;
+	applySubscriptionFrameRate();
+}
+
+void NaoInterface::setRegionOfInterest(float x, float y, float width, float height, int maxWidth)
+{
+	LOCKER(s_mutexCamUpdate);
+
+	s_roiX = std::max(0.0f, std::min(x, 1.0f));
+	s_roiY = std::max(0.0f, std::min(y, 1.0f));
+	s_roiWidth = std::max(0.0f, std::min(width, 1.0f - s_roiX));
+	s_roiHeight = std::max(0.0f, std::min(height, 1.0f - s_roiY));
+	s_roiMaxWidth = maxWidth;
+	s_roiEnabled = true;
+}
+
+void NaoInterface::clearRegionOfInterest()
+{
+	LOCKER(s_mutexCamUpdate);
+
+	s_roiEnabled = false;
+}
+
+bool NaoInterface::hasRegionOfInterest() const
+{
+	return s_roiEnabled;
+}
+
+void NaoInterface::getStreamStats(NaoStreamStats &stats) const
+{
+	LOCKER(s_mutexCamUpdate);
+
+	stats = s_streamStats;
+}
+
+void NaoInterface::setFrameDemand(int consumer, int demand)
+{
+	LOCKER(s_mutexCamUpdate);
+
+	if (consumer < 0 || consumer >= NAO_CONSUMER_COUNT)
+		return;
+
+	s_consumerDemand[consumer] = demand;
+	int highest = NAO_DEMAND_NONE;
+	for (int i = 0; i < NAO_CONSUMER_COUNT; i++)
+		highest = std::max(highest, s_consumerDemand[i]);
+	if (highest == s_demand)
+		return;
+
+	accountDemandPeriod();
+	s_demand = highest;
+	if (s_cameraProxy == NULL)
+		return;
+
+	if (s_demand == NAO_DEMAND_NONE)
+	{
+		// the last frame and the pipelines stay as they are
+		unsubscribeCamera();
+	}
+	else if (s_cameraClientName.length() == 0)
+	{
+		try
+		{
+			subscribeCamera();
+		}
+		catch( AL::ALError e)
+		{
+			std::cerr << "Cannot subscribe camera: " << e.what() << std::endl;
+		}
+	}
+	else
+	{
+		applySubscriptionResolution();
+		applySubscriptionFrameRate();
+	}
+}
+
+int NaoInterface::frameDemand() const
+{
+	return s_demand;
+}
+
+int NaoInterface::subscribedFrameRate() const
+{
+	LOCKER(s_mutexCamUpdate);
+
+	return s_cameraClientName.length() > 0 ? s_subscribedFrameRate : 0;
+}
+
+void NaoInterface::getDemandStats(NaoDemandStats &stats) const
+{
+	LOCKER(s_mutexCamUpdate);
+
+	accountDemandPeriod();
+	stats = s_demandStats;
+}
+
+void NaoInterface::setFilterEnabled(int filter, bool enabled)
+{
+	LOCKER(s_mutexCamUpdate);
+
+	if (s_filterPipeline == NULL)
+	{
+		if (!enabled)
+			return;
+		s_filterPipeline = new FilterPipeline();
+	}
+	s_filterPipeline->setEnabled(filter, enabled);
+}
+
+void NaoInterface::getFilterStats(int filter, NaoFilterStats &stats) const
+{
+	LOCKER(s_mutexCamUpdate);
+
+	if (s_filterPipeline == NULL)
+	{
+		stats.enabled = false;
+		stats.averageUSecs = 0;
+		stats.runs = 0;
+		stats.skipped = 0;
+		return;
+	}
+	s_filterPipeline->getStats(filter, stats);
+}
+
+void NaoInterface::setAnalysisEnabled(bool enabled, const std::string &faceCascadePath)
+{
+	// Deleting the analyzer joins workers that may be in the middle of a
+	// detection, so it is swapped out under the lock and deleted after it.
+	VisionAnalyzer *analyzer = enabled ? new VisionAnalyzer(faceCascadePath) : NULL;
+	{
+		LOCKER(s_mutexCamUpdate);
+		std::swap(analyzer, s_visionAnalyzer);
+	}
+	delete analyzer;
+}
+
+int NaoInterface::getDetections(NaoDetection *detections, int maxDetections, long long *timestamp) const
+{
+	LOCKER(s_mutexCamUpdate);
+
+	*timestamp = 0;
+	if (s_visionAnalyzer == NULL)
+		return 0;
+	return s_visionAnalyzer->getDetections(detections, maxDetections, timestamp);
+}
+
+void NaoInterface::getAnalysisStats(NaoAnalysisStats &stats) const
+{
+	LOCKER(s_mutexCamUpdate);
+
+	stats.analyzed = 0;
+	stats.dropped = 0;
+	stats.lastUSecs = 0;
+	if (s_visionAnalyzer)
+		s_visionAnalyzer->getStats(stats);
+}
+
+long long NaoInterface::cameraTimestamp() const
+{
+	return s_frameTimestamp;
+}
+
+void NaoInterface::setReplayBuffer(int seconds, int maxBytes)
+{
+	s_replayBuffer.configure(seconds, maxBytes);
+}
+
+void NaoInterface::getReplayInfo(NaoReplayInfo &info) const
+{
+	s_replayBuffer.getInfo(info);
+}
+
+bool NaoInterface::getReplayFrame(long long timestamp, unsigned char *buffer, int bufferSize,
+								  int *width, int *height, int *colorSpace, long long *frameTimestamp) const
+{
+	return s_replayBuffer.getFrame(timestamp, buffer, bufferSize, width, height, colorSpace, frameTimestamp);
+}
+
+int NaoInterface::getReplayAudio(long long from, long long to, short *buffer, int maxSamples) const
+{
+	return s_replayBuffer.getAudio(from, to, buffer, maxSamples);
+}
+
+void NaoInterface::setHeadTarget(float yaw, float pitch)
+{
+	LOCKER(s_mutexHead);
+
+	if (s_headController)
+		s_headController->setTarget(yaw, pitch);
+}
+
+bool NaoInterface::getHeadTarget(float *yaw, float *pitch) const
+{
+	LOCKER(s_mutexHead);
+
+	if (s_headController == NULL)
+		return false;
+	s_headController->getTarget(yaw, pitch);
+	return true;
+}
+
+void NaoInterface::getHeadStats(NaoHeadStats &stats) const
+{
+	LOCKER(s_mutexHead);
+
+	stats.requested = 0;
+	stats.sent = 0;
+	stats.coalesced = 0;
+	stats.failed = 0;
+	stats.lastLatencyUSecs = 0;
+	stats.averageLatencyUSecs = 0;
+	if (s_headController)
+		s_headController->getStats(stats);
+}
+
+void NaoInterface::setHeadSimulation(bool enabled)
+{
+	LOCKER(s_mutexHead);
+
+	s_headSimulated = enabled;
+	if (s_motionProxy)
+		return;		// the robot is in control
+	delete s_headController;
+	s_headController = enabled ? new HeadController(new SimulatedHeadMotion()) : NULL;
+}
+
+void NaoInterface::audioReceived(const short *data, int samples, long long timestamp)
+{
+	std::vector<short> concealed;		// only filled, and allocated, after a gap
+	int count = 0;
+	long long blockTimestamp = 0;
+	const short *block = s_audioConcealer.process(data, samples, timestamp, concealed, &count, &blockTimestamp);
+
+	s_replayBuffer.addAudio(block, count, blockTimestamp);
+
+	if (m_audioOutput)
+		m_audioOutput->writeData(block, count, count - samples);
+}
+
+void NaoInterface::getAudioStats(NaoAudioStats &stats) const
+{
+	s_audioConcealer.getStats(stats);
+}
+
+int NaoInterface::cameraWidth() const
+{
+	return s_frameWidth;
+}
+
+int NaoInterface::cameraHeight() const
+{
+	return s_frameHeight;
+}
+
+int NaoInterface::cameraColorSpace() const
+{
+	return s_frameColorSpace;
+}
+
+static int toALResolution(int resolution)
+{
+	switch (resolution)
+	{
+	case NAO_RES_QQVGA:	return AL::kQQVGA;
+	case NAO_RES_VGA:	return AL::kVGA;
+	case NAO_RES_4VGA:	return AL::k4VGA;
+	default:			return AL::kQVGA;
+	}
+}
+
+static int toALColorSpace(int colorSpace)
+{
+	switch (colorSpace)
+	{
+	case NAO_CS_BGR:	return AL::kBGRColorSpace;
+	case NAO_CS_YUV422:	return AL::kYUV422ColorSpace;
+	case NAO_CS_Y:		return AL::kYuvColorSpace;
+	case NAO_CS_HSY:	return AL::kHSYColorSpace;
+	default:			return AL::kRGBColorSpace;
+	}
+}
+
+static int fromALColorSpace(int alColorSpace)
+{
+	if (alColorSpace == AL::kBGRColorSpace)
+		return NAO_CS_BGR;
+	if (alColorSpace == AL::kYUV422ColorSpace)
+		return NAO_CS_YUV422;
+	if (alColorSpace == AL::kYuvColorSpace)
+		return NAO_CS_Y;
+	if (alColorSpace == AL::kHSYColorSpace)
+		return NAO_CS_HSY;
+	return NAO_CS_RGB;
+}
+
+//static
+int NaoInterface::resolutionWidth(int resolution)
+{
+	switch (resolution)
+	{
+	case NAO_RES_QQVGA:	return 160;
+	case NAO_RES_VGA:	return 640;
+	case NAO_RES_4VGA:	return 1280;
+	default:			return 320;
+	}
+}
+
+//static
+int NaoInterface::resolutionHeight(int resolution)
+{
+	return resolutionWidth(resolution) * 3 / 4;
+}
+
+bool NaoInterface::subscribeSnapshot(int resolution, int frames)
+{
+	LOCKER(s_mutexSnapshot);
+
+	if (s_snapshotProxy == NULL)
+		return false;
+
+	// A high resolution frame is expensive for the robot: ask for no more
+	// than spreads the burst over about a second.
+	int fps = std::max(SNAPSHOT_MIN_FPS, std::min(frames, CAMERA_FPS));
+	try
+	{
+		if (s_snapshotClientName.length() > 0)
+		{
+			s_snapshotProxy->unsubscribe(s_snapshotClientName);
+			s_snapshotClientName = "";
+		}
+		s_snapshotClientName = s_snapshotProxy->subscribe("snapshot", toALResolution(resolution), AL::kRGBColorSpace, fps);
+	}
+	catch( AL::ALError e)
+	{
+		std::cerr << "Cannot subscribe snapshot: " << e.what() << std::endl;
+		return false;
+	}
+	s_snapshotFrameRate = fps;
+	s_snapshotTimestamp = 0;
+	return true;
+}
+
+void NaoInterface::unsubscribeSnapshot()
+{
+	LOCKER(s_mutexSnapshot);
+
+	if (s_snapshotProxy && s_snapshotClientName.length() > 0)
+	{
+		try
+		{
+			s_snapshotProxy->unsubscribe(s_snapshotClientName);
+		}
+		catch( AL::ALError e)
+		{
+		}
+	}
+	s_snapshotClientName = "";
+}
+
+bool NaoInterface::captureSnapshot(unsigned char *buffer, int bufferSize, int *width, int *height)
+{
+	long long interval = 0;
+	{
+		LOCKER(s_mutexSnapshot);
+
+		if (s_snapshotProxy == NULL || s_snapshotClientName.length() == 0)
+			return false;
+		interval = 1000000 / s_snapshotFrameRate;
+	}
+
+	// The first image after subscribing may predate the request, and polling
+	// faster than the subscription returns the same image again: only a
+	// frame newer than the last one seen is taken. The lock is only held for
+	// one request at a time, so disconnect() is not kept waiting for the
+	// whole burst; the loop stops once it has taken the subscription away.
+	long long deadline = getTimeUSecs() + 2 * interval + SNAPSHOT_TIMEOUT_USECS;
+	while (getTimeUSecs() < deadline)
+	{
+		{
+			LOCKER(s_mutexSnapshot);
+
+			if (s_snapshotProxy == NULL || s_snapshotClientName.length() == 0)
+				return false;
+			try
+			{
+				// Same layout as in updateCameraView(); copy straight into the caller's
+				// buffer so the burst does not allocate per frame.
+				AL::ALValue img = s_snapshotProxy->getImageRemote(s_snapshotClientName);
+				int w = (int) img[0];
+				int h = (int) img[1];
+				int layers = (int) img[2];
+				long long timestamp = (long long)(int) img[4] * 1000000 + (int) img[5];
+				bool fresh = s_snapshotTimestamp > 0 && timestamp > s_snapshotTimestamp;
+				int size = w * h * layers;
+				bool ok = fresh && size <= bufferSize && img[6].getSize() >= size;
+				if (ok)
+				{
+					memcpy(buffer, img[6].GetBinary(), size);
+					*width = w;
+					*height = h;
+				}
+				s_snapshotTimestamp = std::max(s_snapshotTimestamp, timestamp);
+				s_snapshotProxy->releaseImage(s_snapshotClientName);
+				if (fresh)
+					return ok;
+			}
+			catch( AL::ALError e)
+			{
+				std::cerr << "Cannot capture snapshot: " << e.what() << std::endl;
+				return false;
+			}
+		}
+		qi::os::msleep((int)(interval / 4000) + 1);
+	}
+	std::cerr << "Cannot capture snapshot: no new frame" << std::endl;
+	return false;
+}
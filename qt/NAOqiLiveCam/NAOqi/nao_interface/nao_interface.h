@@ -16,11 +16,142 @@ const int NBOFOUTPUTCHANNELS_IN = 1;    // Mono
 const int NBOFOUTPUTCHANNELS_OUT = 1;   // Mono
 const int BUFFERSAMPLESIZEMSEC = 1000;  // Sample size with msec. 
 const int CAMERA_FPS = 10;
+const int SNAPSHOT_MAX_BURST = 10;		// Max frames buffered for a single burst capture
+const int LOW_DEMAND_FPS = 5;			// Frame rate while only background consumers need frames
+const int REPLAY_SECONDS = 20;			// Instant replay length
+const int REPLAY_MAX_BYTES = 64 * 1024 * 1024;	// Frame memory of the instant replay
+
+// Camera resolutions (same order as kQQVGA .. k4VGA in alvisiondefinitions.h)
+enum NaoCameraResolution
+{
+	NAO_RES_QQVGA = 0,	// 160x120
+	NAO_RES_QVGA,		// 320x240
+	NAO_RES_VGA,		// 640x480
+	NAO_RES_4VGA		// 1280x960
+};
+
+// Color spaces the preview subscription can deliver
+enum NaoColorSpace
+{
+	NAO_CS_RGB = 0,		// 3 layers R G B
+	NAO_CS_BGR,			// 3 layers B G R
+	NAO_CS_YUV422,		// 2 bytes per pixel Y0 U Y1 V
+	NAO_CS_Y,			// 1 layer, luminance only
+	NAO_CS_HSY			// 3 layers H S Y
+};
+
+// Post processing stages, applied in this order
+enum NaoFrameFilter
+{
+	NAO_FILTER_DENOISE = 0,
+	NAO_FILTER_WHITE_BALANCE,
+	NAO_FILTER_GAMMA,
+	NAO_FILTER_SHARPEN,
+	NAO_FILTER_COUNT
+};
+
+struct NaoFilterStats
+{
+	bool		enabled;
+	int			averageUSecs;	// CPU time per frame, summed over tiles
+	long long	runs;
+	long long	skipped;		// frames the stage was left out of
+};
+
+enum NaoDetectionKind
+{
+	NAO_DETECT_FACE = 0,
+	NAO_DETECT_PERSON
+};
+
+// Detection box in normalized coordinates of the frame it was found in
+struct NaoDetection
+{
+	float	x;
+	float	y;
+	float	width;
+	float	height;
+	int		kind;
+};
+
+struct NaoAnalysisStats
+{
+	long long	analyzed;
+	long long	dropped;		// frames replaced by a newer one before analysis
+	int			lastUSecs;
+};
+
+struct NaoStreamStats
+{
+	long long	frames;
+	long long	wireBytes;		// bytes received through getImageRemote
+	long long	displayBytes;	// bytes handed to the viewer after crop / scale
+	long long	roundTripUSecs;	// total time spent in getImageRemote
+	int			lastRoundTripUSecs;
+	int			lastFrameBytes;
+};
+
+// Consumers of the preview stream
+enum NaoFrameConsumer
+{
+	NAO_CONSUMER_VIEW = 0,
+	NAO_CONSUMER_RECORDER,
+	NAO_CONSUMER_ANALYSIS,
+	NAO_CONSUMER_COUNT
+};
+
+// What a consumer needs from the preview stream
+enum NaoFrameDemand
+{
+	NAO_DEMAND_NONE = 0,	// no frames, the camera subscription is released
+	NAO_DEMAND_LOW,			// LOW_DEMAND_FPS at QVGA at most
+	NAO_DEMAND_FULL			// the configured frame rate and resolution
+};
+
+struct NaoDemandStats
+{
+	long long	pausedUSecs;	// time without camera subscription
+	long long	throttledUSecs;	// time at low demand
+	long long	savedFrames;	// frames not pulled compared to full demand
+	long long	savedBytes;
+	long long	savedCpuUSecs;	// capture thread CPU of the frames not pulled
+};
+
+struct NaoHeadStats
+{
+	long long	requested;			// targets set by the operator
+	long long	sent;				// commands issued to the motion service
+	long long	coalesced;			// targets replaced before the next control tick
+	long long	failed;				// commands the motion service rejected
+	int			lastLatencyUSecs;	// operator input to the head starting to move
+	int			averageLatencyUSecs;
+};
+
+struct NaoAudioStats
+{
+	long long	blocks;
+	long long	gaps;				// holes found in the block time stamps
+	long long	outages;			// gaps too long to conceal
+	long long	lostUSecs;			// total length of the gaps
+	long long	concealedUSecs;		// synthesized audio
+	int			lastConcealUSecs;	// CPU time of the last concealment
+};
+
+struct NaoReplayInfo
+{
+	long long	firstTimestamp;	// oldest frame held, usec
+	long long	lastTimestamp;	// newest frame held
+	int			frames;
+	int			bytesUsed;
+	int			bytesCapacity;
+	int			maxFrameBytes;	// largest frame held, to size getReplayFrame() buffers
+};
 
 class NAOqiToPCAudioInterface
 {
 public:
-    virtual void writeData(const short *data, int samples) = 0;
+    // The first concealedSamples of data stand in for lost audio.
+    virtual void writeData(const short *data, int samples, int concealedSamples) = 0;
 };
 
 class NaoInterface
@@ -40,6 +171,87 @@ public:
 
 	unsigned char*	updateCameraView();
 
+	// Preview format. Width/height/color space describe the buffer returned
+	// by the last updateCameraView() call.
+	void	setCameraResolution(int resolution);
+	void	setCameraColorSpace(int colorSpace);
+	void	setCameraFrameRate(int fps);
+	int		cameraWidth() const;
+	int		cameraHeight() const;
+	int		cameraColorSpace() const;
+
+	// Region of interest / digital zoom, in normalized frame coordinates.
+	// Frames are cropped to the region and downscaled to at most maxWidth
+	// pixels wide (0 keeps the cropped size). ALVideoDevice cannot crop on
+	// the robot, so whole frames at the subscribed resolution still cross
+	// the link and the viewer upscales the crop.
+	void	setRegionOfInterest(float x, float y, float width, float height, int maxWidth);
+	void	clearRegionOfInterest();
+	bool	hasRegionOfInterest() const;
+
+	void	getStreamStats(NaoStreamStats &stats) const;
+
+	// Demand driven capture: the stream follows the highest demand of its
+	// consumers. With no demand the subscription is released (the last
+	// frame stays available) and it is taken again on the next demand.
+	void	setFrameDemand(int consumer, int demand);
+	int		frameDemand() const;
+	int		subscribedFrameRate() const;	// 0 while paused
+	void	getDemandStats(NaoDemandStats &stats) const;
+
+	// Post processing of RGB / BGR frames on a worker pool. The frame
+	// returned by updateCameraView() is then the newest one through the
+	// chain, which is usually one capture behind.
+	void	setFilterEnabled(int filter, bool enabled);
+	void	getFilterStats(int filter, NaoFilterStats &stats) const;
+
+	// Asynchronous face / person detection on the displayed frames. An empty
+	// cascade path only runs the person detector.
+	void	setAnalysisEnabled(bool enabled, const std::string &faceCascadePath);
+	int		getDetections(NaoDetection *detections, int maxDetections, long long *timestamp) const;
+	void	getAnalysisStats(NaoAnalysisStats &stats) const;
+
+	// Camera time stamp (usec) of the frame returned by updateCameraView()
+	long long	cameraTimestamp() const;
+
+	// Instant replay of the frames returned by updateCameraView() and of the
+	// received audio. The ring holds at most the given seconds and frame
+	// bytes; it is allocated here, live capture keeps filling it without
+	// allocating. 0 seconds releases it.
+	void	setReplayBuffer(int seconds, int maxBytes);
+	void	getReplayInfo(NaoReplayInfo &info) const;
+	bool	getReplayFrame(long long timestamp, unsigned char *buffer, int bufferSize,
+						   int *width, int *height, int *colorSpace, long long *frameTimestamp) const;
+	int		getReplayAudio(long long from, long long to, short *buffer, int maxSamples) const;
+
+	// Head pan / tilt in radians (yaw positive to the left, pitch positive
+	// down), clamped to the joint limits. Targets are coalesced to at most
+	// one motion command per control tick. With simulation enabled a local
+	// stand-in motion service takes ALMotion's place while no robot is
+	// connected.
+	void	setHeadTarget(float yaw, float pitch);
+	bool	getHeadTarget(float *yaw, float *pitch) const;
+	void	getHeadStats(NaoHeadStats &stats) const;
+	void	setHeadSimulation(bool enabled);
+
+	// Called by the audio capture module for every block received. Gaps in
+	// the block time stamps are detected and short ones concealed before
+	// the audio is recorded and played. Blocks come from one thread only,
+	// in order.
+	void	audioReceived(const short *data, int samples, long long timestamp);
+	void	getAudioStats(NaoAudioStats &stats) const;
+
+	// High resolution still capture. The snapshot subscription is independent
+	// from the preview one, so the preview keeps running while it is active.
+	// Its frame rate follows the burst length; captureSnapshot() only returns
+	// frames taken after the subscription and never the same frame twice.
+	bool	subscribeSnapshot(int resolution, int frames);
+	void	unsubscribeSnapshot();
+	bool	captureSnapshot(unsigned char *buffer, int bufferSize, int *width, int *height);
+
+	static int	resolutionWidth(int resolution);
+	static int	resolutionHeight(int resolution);
+
 private:
 	NAOqiToPCAudioInterface *m_audioOutput;
 
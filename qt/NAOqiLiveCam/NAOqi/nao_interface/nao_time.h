@@ -0,0 +1,32 @@
+/**
+ * Clock helpers shared by the NaoInterface sources
+ * Created 2026/10/19
+ */
+
+#ifndef NAO_TIME_H
+#define NAO_TIME_H
+
+#include <time.h>
+#include <qi/os.hpp>
+
+// Current time in usec, the same clock NAOqi uses for frame time stamps.
+inline long long getTimeUSecs()
+{
+	qi::os::timeval timeStruct;
+	qi::os::gettimeofday(&timeStruct);
+	return (long long)timeStruct.tv_sec * 1000000 + (long long)timeStruct.tv_usec;
+}
+
+// CPU time used so far by the calling thread in usec, 0 where the system
+// has no per thread clock.
+inline long long getThreadCpuUSecs()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec now;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0)
+		return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+	return 0;
+}
+
+#endif // NAO_TIME_H
@@ -0,0 +1,254 @@
+/**
+ * Instant replay ring of recent frames and audio
+ * Created 2026/10/19
+ */
+
+#include "replay_buffer.h"
+
+#include <cstring>
+#include <algorithm>
+
+static const int MAX_FRAMES_PER_SECOND = 30;
+static const int MAX_AUDIO_BLOCKS_PER_SECOND = 50;
+
+ReplayBuffer::ReplayBuffer()
+	: m_windowUSecs(0)
+	, m_arena(NULL)
+	, m_arenaSize(0)
+	, m_writeOffset(0)
+	, m_frameHead(0)
+	, m_frameCount(0)
+	, m_samplesWritten(0)
+	, m_blockHead(0)
+	, m_blockCount(0)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+}
+
+ReplayBuffer::~ReplayBuffer()
+{
+	release();
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void ReplayBuffer::configure(int seconds, int maxFrameBytes)
+{
+	pthread_mutex_lock(&m_mutex);
+	release();
+	if (seconds > 0 && maxFrameBytes > 0)
+	{
+		m_windowUSecs = (long long) seconds * 1000000;
+		m_arena = new unsigned char[maxFrameBytes];
+		m_arenaSize = maxFrameBytes;
+		m_frames.resize(seconds * MAX_FRAMES_PER_SECOND);
+		m_samples.resize(seconds * SAMPLERATE_IN);
+		m_blocks.resize(seconds * MAX_AUDIO_BLOCKS_PER_SECOND);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+// Called with the mutex held.
+void ReplayBuffer::release()
+{
+	delete [] m_arena;
+	m_arena = NULL;
+	m_arenaSize = 0;
+	m_writeOffset = 0;
+	std::vector<FrameRecord>().swap(m_frames);
+	m_frameHead = 0;
+	m_frameCount = 0;
+
+	std::vector<short>().swap(m_samples);
+	m_samplesWritten = 0;
+	std::vector<AudioRecord>().swap(m_blocks);
+	m_blockHead = 0;
+	m_blockCount = 0;
+}
+
+// Called with the mutex held.
+void ReplayBuffer::evictOldestFrame()
+{
+	m_frameHead = (m_frameHead + 1) % m_frames.size();
+	m_frameCount--;
+}
+
+void ReplayBuffer::addFrame(const cv::Mat &frame, int colorSpace, long long timestamp)
+{
+	int rowBytes = frame.cols * (int) frame.elemSize();
+	int size = rowBytes * frame.rows;
+
+	pthread_mutex_lock(&m_mutex);
+	if (m_arena == NULL || size == 0 || size > m_arenaSize)
+	{
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+
+	if (m_frameCount > 0)
+	{
+		long long newest = frameAt(m_frameCount - 1).timestamp;
+		// the same frame fetched twice is stored once
+		if (timestamp == newest)
+		{
+			pthread_mutex_unlock(&m_mutex);
+			return;
+		}
+		// the robot clock went back (reconnect): start over
+		if (timestamp < newest)
+			m_frameCount = 0;
+	}
+
+	while (m_frameCount > 0 && (m_frameCount == (int) m_frames.size() || frameAt(0).timestamp < timestamp - m_windowUSecs))
+		evictOldestFrame();
+
+	int offset = m_frameCount > 0 ? m_writeOffset : 0;
+	if (offset + size > m_arenaSize)
+	{
+		// Wrap around. Frames left in the tail of the arena are the oldest
+		// ones and go first.
+		while (m_frameCount > 0 && frameAt(0).offset >= offset)
+			evictOldestFrame();
+		offset = 0;
+	}
+	while (m_frameCount > 0 && frameAt(0).offset < offset + size && frameAt(0).offset + frameAt(0).size > offset)
+		evictOldestFrame();
+
+	unsigned char *dst = m_arena + offset;
+	for (int y = 0; y < frame.rows; y++)
+		memcpy(dst + y * rowBytes, frame.ptr(y), rowBytes);
+
+	FrameRecord &record = m_frames[(m_frameHead + m_frameCount) % m_frames.size()];
+	record.timestamp = timestamp;
+	record.offset = offset;
+	record.size = size;
+	record.width = frame.cols;
+	record.height = frame.rows;
+	record.colorSpace = colorSpace;
+	m_frameCount++;
+	m_writeOffset = offset + size;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void ReplayBuffer::addAudio(const short *samples, int count, long long timestamp)
+{
+	pthread_mutex_lock(&m_mutex);
+	int capacity = (int) m_samples.size();
+	if (capacity == 0 || count <= 0)
+	{
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+
+	if (count > capacity)
+	{
+		samples += count - capacity;
+		timestamp += (long long)(count - capacity) * 1000000 / SAMPLERATE_IN;
+		count = capacity;
+	}
+
+	int blockCapacity = (int) m_blocks.size();
+	if (m_blockCount > 0 && timestamp < m_blocks[(m_blockHead + m_blockCount - 1) % blockCapacity].timestamp)
+		m_blockCount = 0;
+
+	// drop blocks whose samples are about to be overwritten
+	long long end = m_samplesWritten + count;
+	while (m_blockCount > 0 && (m_blockCount == blockCapacity || m_blocks[m_blockHead].start < end - capacity))
+	{
+		m_blockHead = (m_blockHead + 1) % blockCapacity;
+		m_blockCount--;
+	}
+
+	int pos = (int)(m_samplesWritten % capacity);
+	int first = std::min(count, capacity - pos);
+	memcpy(&m_samples[pos], samples, first * sizeof(short));
+	memcpy(&m_samples[0], samples + first, (count - first) * sizeof(short));
+
+	AudioRecord &record = m_blocks[(m_blockHead + m_blockCount) % blockCapacity];
+	record.timestamp = timestamp;
+	record.start = m_samplesWritten;
+	record.count = count;
+	m_blockCount++;
+	m_samplesWritten = end;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void ReplayBuffer::getInfo(NaoReplayInfo &info) const
+{
+	pthread_mutex_lock(&m_mutex);
+	info.frames = m_frameCount;
+	info.firstTimestamp = m_frameCount > 0 ? frameAt(0).timestamp : 0;
+	info.lastTimestamp = m_frameCount > 0 ? frameAt(m_frameCount - 1).timestamp : 0;
+	info.bytesUsed = 0;
+	info.bytesCapacity = m_arenaSize;
+	info.maxFrameBytes = 0;
+	for (int i = 0; i < m_frameCount; i++)
+	{
+		info.bytesUsed += frameAt(i).size;
+		info.maxFrameBytes = std::max(info.maxFrameBytes, frameAt(i).size);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+bool ReplayBuffer::getFrame(long long timestamp, unsigned char *buffer, int bufferSize,
+							int *width, int *height, int *colorSpace, long long *frameTimestamp) const
+{
+	pthread_mutex_lock(&m_mutex);
+	if (m_frameCount == 0)
+	{
+		pthread_mutex_unlock(&m_mutex);
+		return false;
+	}
+
+	int found = 0;
+	int low = 0;
+	int high = m_frameCount - 1;
+	while (low <= high)
+	{
+		int mid = (low + high) / 2;
+		if (frameAt(mid).timestamp <= timestamp)
+		{
+			found = mid;
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+
+	const FrameRecord &record = frameAt(found);
+	bool ok = record.size <= bufferSize;
+	if (ok)
+	{
+		memcpy(buffer, m_arena + record.offset, record.size);
+		*width = record.width;
+		*height = record.height;
+		*colorSpace = record.colorSpace;
+		*frameTimestamp = record.timestamp;
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return ok;
+}
+
+int ReplayBuffer::getAudio(long long from, long long to, short *buffer, int maxSamples) const
+{
+	pthread_mutex_lock(&m_mutex);
+	int capacity = (int) m_samples.size();
+	int copied = 0;
+	for (int i = 0; i < m_blockCount && copied < maxSamples; i++)
+	{
+		const AudioRecord &block = m_blocks[(m_blockHead + i) % m_blocks.size()];
+		long long duration = (long long) block.count * 1000000 / SAMPLERATE_IN;
+		long long begin = std::max(0LL, from - block.timestamp);
+		long long end = std::min(duration, to - block.timestamp);
+		if (begin >= end)
+			continue;
+		long long first = begin * SAMPLERATE_IN / 1000000;
+		long long last = std::min((long long) block.count, end * SAMPLERATE_IN / 1000000);
+		last = std::min(last, first + maxSamples - copied);
+		for (long long s = first; s < last; s++)
+			buffer[copied++] = m_samples[(block.start + s) % capacity];
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return copied;
+}
@@ -0,0 +1,82 @@
+/**
+ * Instant replay ring of recent frames and audio
+ * Created 2026/10/19
+ */
+
+#ifndef REPLAY_BUFFER_H
+#define REPLAY_BUFFER_H
+
+#include <vector>
+#include <pthread.h>
+#include <opencv2/core/core.hpp>
+
+#include "nao_interface.h"
+
+/**
+ * Instant replay ring of the last few seconds of frames and audio blocks.
+ * All memory is allocated by configure(): frames are packed back to back
+ * in a byte arena which wraps around, audio goes to a sample ring. Adding
+ * data evicts the oldest entries, so live capture never allocates. Frames
+ * and audio blocks both carry NAOqi time stamps (usec) and are looked up
+ * by time.
+ */
+class ReplayBuffer
+{
+public:
+	ReplayBuffer();
+	~ReplayBuffer();
+
+	void	configure(int seconds, int maxFrameBytes);
+
+	void	addFrame(const cv::Mat &frame, int colorSpace, long long timestamp);
+	void	addAudio(const short *samples, int count, long long timestamp);
+
+	void	getInfo(NaoReplayInfo &info) const;
+
+	// Newest frame taken at or before timestamp (the oldest one if the
+	// time stamp is older than the whole buffer).
+	bool	getFrame(long long timestamp, unsigned char *buffer, int bufferSize,
+					 int *width, int *height, int *colorSpace, long long *frameTimestamp) const;
+	int		getAudio(long long from, long long to, short *buffer, int maxSamples) const;
+
+private:
+	struct FrameRecord
+	{
+		long long	timestamp;
+		int			offset;
+		int			size;
+		int			width;
+		int			height;
+		int			colorSpace;
+	};
+
+	struct AudioRecord
+	{
+		long long	timestamp;
+		long long	start;		// absolute sample index
+		int			count;
+	};
+
+	void	release();
+	void	evictOldestFrame();
+	const FrameRecord&	frameAt(int index) const { return m_frames[(m_frameHead + index) % m_frames.size()]; }
+
+private:
+	mutable pthread_mutex_t		m_mutex;
+	long long					m_windowUSecs;
+
+	unsigned char				*m_arena;
+	int							m_arenaSize;
+	int							m_writeOffset;
+	std::vector<FrameRecord>	m_frames;
+	int							m_frameHead;
+	int							m_frameCount;
+
+	std::vector<short>			m_samples;
+	long long					m_samplesWritten;
+	std::vector<AudioRecord>	m_blocks;
+	int							m_blockHead;
+	int							m_blockCount;
+};
+
+#endif // REPLAY_BUFFER_H
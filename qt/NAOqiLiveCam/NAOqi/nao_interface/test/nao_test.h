@@ -0,0 +1,52 @@
+/**
+ * Test runner shared by the NaoInterface and viewer tests
+ * Created 2026/10/19
+ */
+
+#ifndef NAO_TEST_H
+#define NAO_TEST_H
+
+/**
+ * The tests and benchmarks live in one binary, the soak in a second one.
+ * Each case registers itself with NAO_TEST() and is run by name:
+ *     nao_interface_test <case> [--option value ...]
+ * Without a name every case except the manual ones (which need a robot or
+ * run for hours) is run. A case fails when any NAO_CHECK() in it fails.
+ */
+
+typedef void (*NaoTestFunction)(int argc, char **argv);
+
+class NaoTestCase
+{
+public:
+	NaoTestCase(const char *name, NaoTestFunction function, bool manual);
+};
+
+void		naoTestFailure(const char *file, int line, const char *expression);
+
+// Value of "--name value" on the command line, or defaultValue.
+double		naoTestOption(int argc, char **argv, const char *name, double defaultValue);
+const char*	naoTestStringOption(int argc, char **argv, const char *name, const char *defaultValue);
+
+// Monotonic clock for the benchmarks, usec
+long long	naoTestClockUSecs();
+
+// most cases take no options and leave argc / argv alone
+#ifdef __GNUC__
+#define NAO_TEST_UNUSED __attribute__((unused))
+#else
+#define NAO_TEST_UNUSED
+#endif
+
+#define NAO_TEST_CASE(name, manual) \
+	static void name(int argc, char **argv); \
+	static NaoTestCase s_testCase_##name(#name, name, manual); \
+	static void name(int argc NAO_TEST_UNUSED, char **argv NAO_TEST_UNUSED)
+
+#define NAO_TEST(name)			NAO_TEST_CASE(name, false)
+#define NAO_MANUAL_TEST(name)	NAO_TEST_CASE(name, true)
+
+#define NAO_CHECK(condition) \
+	((condition) ? (void)0 : naoTestFailure(__FILE__, __LINE__, #condition))
+
+#endif // NAO_TEST_H
@@ -0,0 +1,186 @@
+/**
+ * Audio gap concealment on a scripted loss pattern
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "audio_concealer.h"
+
+static const int BLOCK_SAMPLES = 1024;					// 64 ms, as AudioCaptureRemote delivers them
+static const long long BLOCK_USECS = BLOCK_SAMPLES * 1000000LL / SAMPLERATE_IN;
+static const int BLOCK_COUNT = 60;
+static const double TONE_HZ = 200.0;					// period of 80 samples
+static const double AMPLITUDE = 8000.0;
+
+// Largest step between neighbouring samples of the test tone (fundamental
+// and third harmonic); a click is a step well beyond it.
+static const int MAX_STEP = (int)(2.0 * M_PI * TONE_HZ / SAMPLERATE_IN * AMPLITUDE * (1.0 + 3.0 * 0.25)) + 1;
+
+enum BlockFate
+{
+	DELIVERED,
+	LOST,
+	LATE		// delivered with a few ms of time stamp jitter
+};
+
+static BlockFate fateOf(int block)
+{
+	switch (block)
+	{
+	case 10:
+	case 30:
+	case 45:	return LOST;		// single losses, concealed
+	case 20:
+	case 21:	return LOST;		// 128 ms, too long to conceal
+	case 40:	return LATE;
+	default:	return DELIVERED;
+	}
+}
+
+static long long distance(long long a, long long b)
+{
+	return a > b ? a - b : b - a;
+}
+
+static short toneSample(long long n)
+{
+	double t = 2.0 * M_PI * TONE_HZ * n / SAMPLERATE_IN;
+	return (short)(AMPLITUDE * (sin(t) + 0.25 * sin(3.0 * t)) / 1.25);
+}
+
+// The captured audio as the robot sent it, cut into blocks of which some
+// never arrive: three single blocks are concealed, two in a row are an
+// outage, and one late block is jitter and not a gap.
+NAO_TEST(audio_concealer)
+{
+	AudioConcealer concealer;
+	std::vector<short> block(BLOCK_SAMPLES);
+	std::vector<short> concealed;
+	std::vector<short> played;				// everything returned, in order
+	std::vector<size_t> joins;				// where a new returned block starts in played
+	size_t outageStart = 0;
+	long long expectedTimestamp = -1;
+	bool contiguous = true;
+	double worstConcealError = 0;
+	const long long base = 1000000000LL;
+
+	for (int b = 0; b < BLOCK_COUNT; b++)
+	{
+		BlockFate fate = fateOf(b);
+		if (fate == LOST)
+			continue;
+		for (int i = 0; i < BLOCK_SAMPLES; i++)
+			block[i] = toneSample((long long) b * BLOCK_SAMPLES + i);
+		long long timestamp = base + b * BLOCK_USECS + (fate == LATE ? 3000 : 0);
+
+		int count = 0;
+		long long outTimestamp = 0;
+		const short *out = concealer.process(&block[0], BLOCK_SAMPLES, timestamp, concealed, &count, &outTimestamp);
+		bool afterOutage = b == 22;
+		if (b > 0 && fateOf(b - 1) == LOST)
+			NAO_CHECK(out == &concealed[0]);		// the caller's buffer, nothing shared
+		else if (fate != LATE && b > 0 && fateOf(b - 1) == DELIVERED)
+			NAO_CHECK(out == &block[0] && count == BLOCK_SAMPLES);
+
+		if (afterOutage)
+		{
+			// no audio is made up for the outage, the stream fades back in
+			NAO_CHECK(count == BLOCK_SAMPLES);
+			NAO_CHECK(out[0] == 0);
+			outageStart = played.size();
+		}
+		else if (expectedTimestamp >= 0 && fate != LATE && fateOf(b - 1) == LATE)
+		{
+			// the jitter of the late block is absorbed by the next one
+			NAO_CHECK(distance(outTimestamp, expectedTimestamp) <= 3000);
+		}
+		else if (expectedTimestamp >= 0 && fate != LATE)
+		{
+			// a concealed block starts where the previous one ended
+			if (distance(outTimestamp, expectedTimestamp) > 100)
+				contiguous = false;
+		}
+
+		if (count > BLOCK_SAMPLES)
+		{
+			// the concealed samples at full gain continue the real tone
+			int gap = count - BLOCK_SAMPLES;
+			long long first = (long long) b * BLOCK_SAMPLES - gap;
+			for (int i = 0; i < SAMPLERATE_IN / 100; i++)
+				worstConcealError = std::max(worstConcealError, fabs((double) out[i] - toneSample(first + i)));
+		}
+
+		joins.push_back(played.size());
+		played.insert(played.end(), out, out + count);
+		expectedTimestamp = outTimestamp + (long long) count * 1000000 / SAMPLERATE_IN;
+	}
+
+	NaoAudioStats stats;
+	concealer.getStats(stats);
+	printf("blocks %lld  gaps %lld  outages %lld  lost %lld ms  concealed %lld ms  last conceal %d us\n",
+		   stats.blocks, stats.gaps, stats.outages, stats.lostUSecs / 1000, stats.concealedUSecs / 1000,
+		   stats.lastConcealUSecs);
+	NAO_CHECK(stats.blocks == BLOCK_COUNT - 5);
+	NAO_CHECK(stats.gaps == 4);
+	NAO_CHECK(stats.outages == 1);
+	NAO_CHECK(stats.lostUSecs == 5 * BLOCK_USECS);
+	NAO_CHECK(stats.concealedUSecs == 3 * BLOCK_USECS);
+	NAO_CHECK(contiguous);
+
+	printf("conceal error at full gain %.0f of %.0f\n", worstConcealError, AMPLITUDE);
+	NAO_CHECK(worstConcealError < AMPLITUDE * 0.05);
+
+	// No clicks: no step between neighbouring samples, at the block joins or
+	// anywhere else, is larger than the tone itself makes. The outage is a
+	// real hole in the stream, so the step into it is not counted.
+	int worstStep = 0;
+	size_t worstAt = 0;
+	for (size_t i = 1; i < played.size(); i++)
+	{
+		if (i == outageStart)
+			continue;
+		int step = abs(played[i] - played[i - 1]);
+		if (step > worstStep)
+		{
+			worstStep = step;
+			worstAt = i;
+		}
+	}
+	bool atJoin = std::find(joins.begin(), joins.end(), worstAt) != joins.end();
+	printf("largest step %d (limit %d)%s\n", worstStep, MAX_STEP, atJoin ? " at a block join" : "");
+	NAO_CHECK(worstStep <= MAX_STEP);
+}
+
+// While the history is still filling a gap cannot be concealed and counts
+// as an outage; after a reset the next block starts a new stream.
+NAO_TEST(audio_concealer_reset)
+{
+	AudioConcealer concealer;
+	std::vector<short> block(BLOCK_SAMPLES / 4);
+	for (size_t i = 0; i < block.size(); i++)
+		block[i] = toneSample(i);
+	long long blockUSecs = block.size() * 1000000LL / SAMPLERATE_IN;
+
+	std::vector<short> concealed;
+	int count = 0;
+	long long outTimestamp = 0;
+	concealer.process(&block[0], block.size(), 1000000, concealed, &count, &outTimestamp);
+	concealer.process(&block[0], block.size(), 1000000 + 3 * blockUSecs, concealed, &count, &outTimestamp);
+	NaoAudioStats stats;
+	concealer.getStats(stats);
+	NAO_CHECK(stats.gaps == 1 && stats.outages == 1 && stats.concealedUSecs == 0);
+
+	// a new stream starts without a gap
+	concealer.reset();
+	concealer.process(&block[0], block.size(), 5000000, concealed, &count, &outTimestamp);
+	concealer.getStats(stats);
+	NAO_CHECK(stats.gaps == 1);
+	NAO_CHECK(count == (int) block.size() && outTimestamp == 5000000);
+}
@@ -0,0 +1,122 @@
+/**
+ * Head control loop against the simulated motion service
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "head_controller.h"
+#include "nao_time.h"
+
+static const int CONTROL_PERIOD_USECS = 50000;		// HeadController's tick, 20 Hz
+static const int ROUND_TRIP_USECS = 5000;			// SimulatedHeadMotion per call
+static const int ACTUATION_USECS = 40000;			// SimulatedHeadMotion command to motion
+static const int BURST_PERIOD_USECS = 10000;		// drag events, five per tick
+static const int BURST_TARGETS = 100;
+static const int SCHEDULING_SLACK_USECS = 10000;
+
+// Passes the commands on to the simulated head and records when each one
+// went out and where to.
+class RecordingHeadMotion : public HeadMotion
+{
+public:
+	struct Command
+	{
+		long long	time;
+		float		yaw;
+	};
+
+	RecordingHeadMotion() { pthread_mutex_init(&m_mutex, NULL); }
+	~RecordingHeadMotion() { pthread_mutex_destroy(&m_mutex); }
+
+	virtual void setTarget(float yaw, float pitch)
+	{
+		Command command = { getTimeUSecs(), yaw };
+		m_head.setTarget(yaw, pitch);
+		pthread_mutex_lock(&m_mutex);
+		m_commands.push_back(command);
+		pthread_mutex_unlock(&m_mutex);
+	}
+
+	virtual bool getAngles(float *yaw, float *pitch)
+	{
+		return m_head.getAngles(yaw, pitch);
+	}
+
+	std::vector<Command> commands()
+	{
+		pthread_mutex_lock(&m_mutex);
+		std::vector<Command> commands = m_commands;
+		pthread_mutex_unlock(&m_mutex);
+		return commands;
+	}
+
+private:
+	SimulatedHeadMotion		m_head;
+	pthread_mutex_t			m_mutex;
+	std::vector<Command>	m_commands;
+};
+
+// A drag sends targets five times faster than the control tick. Every
+// target is either sent or replaced by a newer one before its tick, each
+// one reaches the motion service within a tick (plus the simulated round
+// trips of the previous tick), the last one is what the head ends up with,
+// and the latency from input to motion is measured.
+NAO_TEST(head_controller)
+{
+	RecordingHeadMotion *motion = new RecordingHeadMotion();
+	HeadController *controller = new HeadController(motion);
+
+	std::vector<long long> targetTimes;
+	float yaw = 0.0f;
+	for (int i = 0; i < BURST_TARGETS; i++)
+	{
+		yaw = 0.5f * (float) sin(2.0 * M_PI * i / BURST_TARGETS) + 0.1f;
+		targetTimes.push_back(getTimeUSecs());
+		controller->setTarget(yaw, 0.0f);
+		usleep(BURST_PERIOD_USECS);
+	}
+	// the last target goes out on the next tick and the head follows it
+	usleep(4 * CONTROL_PERIOD_USECS + ACTUATION_USECS);
+
+	NaoHeadStats stats;
+	controller->getStats(stats);
+	std::vector<RecordingHeadMotion::Command> commands = motion->commands();
+	delete controller;
+
+	printf("requested %lld  sent %lld  coalesced %lld  failed %lld  latency %d us (average %d us)\n",
+		   stats.requested, stats.sent, stats.coalesced, stats.failed, stats.lastLatencyUSecs,
+		   stats.averageLatencyUSecs);
+	NAO_CHECK(stats.requested == BURST_TARGETS);
+	NAO_CHECK(stats.failed == 0);
+	NAO_CHECK(stats.requested == stats.sent + stats.coalesced);
+	NAO_CHECK(stats.sent == (long long) commands.size());
+	NAO_CHECK(stats.sent < stats.requested);
+
+	// the first command after each target leaves within a tick of it, give
+	// or take the round trips of the previous tick and a late wake-up
+	const long long limit = CONTROL_PERIOD_USECS + 2 * ROUND_TRIP_USECS + SCHEDULING_SLACK_USECS;
+	long long worstWait = 0;
+	size_t next = 0;
+	for (size_t i = 0; i < targetTimes.size(); i++)
+	{
+		while (next < commands.size() && commands[next].time < targetTimes[i])
+			next++;
+		long long wait = next < commands.size() ? commands[next].time - targetTimes[i] : limit + 1;
+		worstWait = std::max(worstWait, wait);
+	}
+	printf("longest wait from target to command %lld us (limit %lld)\n", worstWait, limit);
+	NAO_CHECK(worstWait <= limit);
+	NAO_CHECK(!commands.empty() && commands.back().yaw == yaw);
+
+	// the simulated head cannot start moving before its actuation delay
+	NAO_CHECK(stats.lastLatencyUSecs >= ACTUATION_USECS);
+	NAO_CHECK(stats.averageLatencyUSecs >= ACTUATION_USECS);
+}
@@ -0,0 +1,106 @@
+/**
+ * Test runner shared by the NaoInterface and viewer tests
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+
+struct NaoTestEntry
+{
+	const char		*name;
+	NaoTestFunction	function;
+	bool			manual;
+};
+
+// function local so registration does not depend on static init order
+static std::vector<NaoTestEntry>& registry()
+{
+	static std::vector<NaoTestEntry> s_tests;
+	return s_tests;
+}
+
+static int s_failures = 0;
+
+NaoTestCase::NaoTestCase(const char *name, NaoTestFunction function, bool manual)
+{
+	NaoTestEntry entry = { name, function, manual };
+	registry().push_back(entry);
+}
+
+void naoTestFailure(const char *file, int line, const char *expression)
+{
+	std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+	s_failures++;
+}
+
+const char* naoTestStringOption(int argc, char **argv, const char *name, const char *defaultValue)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strncmp(argv[i], "--", 2) == 0 && strcmp(argv[i] + 2, name) == 0)
+			return argv[i + 1];
+	}
+	return defaultValue;
+}
+
+double naoTestOption(int argc, char **argv, const char *name, double defaultValue)
+{
+	const char *value = naoTestStringOption(argc, argv, name, NULL);
+	return value ? atof(value) : defaultValue;
+}
+
+long long naoTestClockUSecs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static bool runTest(const NaoTestEntry &test, int argc, char **argv)
+{
+	std::cout << "[ RUN  ] " << test.name << std::endl;
+	int failures = s_failures;
+	test.function(argc, argv);
+	bool passed = s_failures == failures;
+	std::cout << (passed ? "[  OK  ] " : "[ FAIL ] ") << test.name << std::endl;
+	return passed;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<NaoTestEntry> &tests = registry();
+
+	if (argc > 1 && strcmp(argv[1], "--list") == 0)
+	{
+		for (size_t i = 0; i < tests.size(); i++)
+			std::cout << tests[i].name << (tests[i].manual ? " (manual)" : "") << std::endl;
+		return 0;
+	}
+
+	bool all = argc < 2 || strncmp(argv[1], "--", 2) == 0;
+	int run = 0;
+	int failed = 0;
+	for (size_t i = 0; i < tests.size(); i++)
+	{
+		if (all ? tests[i].manual : strcmp(argv[1], tests[i].name) != 0)
+			continue;
+		run++;
+		if (!runTest(tests[i], argc, argv))
+			failed++;
+	}
+
+	if (run == 0)
+	{
+		std::cerr << "No test named " << argv[1] << ", see --list" << std::endl;
+		return 2;
+	}
+	std::cout << run - failed << " of " << run << " passed" << std::endl;
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+/**
+ * Viewer pixel conversion: output check and throughput against cv::cvtColor
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "pixelconversion.h"
+
+using namespace PixelConversion;
+
+static const int BENCH_RUNS = 5;
+static const long long BENCH_RUN_USECS = 200000;
+
+struct ConversionCase
+{
+	const char	*name;
+	int			colorSpace;
+	int			cvCode;		// cvtColor conversion doing the same job, -1 for a plain copy
+	const char	*cvName;
+};
+
+// HSY has no OpenCV counterpart, HSV is the closest model
+static const ConversionCase s_cases[] =
+{
+	{ "RGB -> RGB888",		NAO_CS_RGB,		-1,					"copyTo" },
+	{ "BGR -> RGB888",		NAO_CS_BGR,		CV_BGR2RGB,			"BGR2RGB" },
+	{ "YUV422 -> RGB32",	NAO_CS_YUV422,	CV_YUV2BGRA_YUYV,	"YUV2BGRA_YUYV" },
+	{ "Y -> RGB32",			NAO_CS_Y,		CV_GRAY2BGRA,		"GRAY2BGRA" },
+	{ "HSY -> RGB888",		NAO_CS_HSY,		CV_HSV2RGB,			"HSV2RGB" }
+};
+static const int CASE_COUNT = sizeof(s_cases) / sizeof(s_cases[0]);
+
+static int bytesPerPixel(int colorSpace)
+{
+	switch (colorSpace)
+	{
+	case NAO_CS_YUV422:	return 2;
+	case NAO_CS_Y:		return 1;
+	default:			return 3;
+	}
+}
+
+static void fillSource(std::vector<uchar> &src, int size)
+{
+	src.resize(size);
+	unsigned int seed = 12345;
+	for (int i = 0; i < size; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		src[i] = (uchar)(seed >> 16);
+	}
+}
+
+// Straight per pixel conversion the kernels must match, RGB order.
+static void referencePixel(int colorSpace, const uchar *src, int x, uchar *rgb)
+{
+	switch (colorSpace)
+	{
+	case NAO_CS_RGB:
+		rgb[0] = src[x * 3]; rgb[1] = src[x * 3 + 1]; rgb[2] = src[x * 3 + 2];
+		break;
+	case NAO_CS_BGR:
+		rgb[0] = src[x * 3 + 2]; rgb[1] = src[x * 3 + 1]; rgb[2] = src[x * 3];
+		break;
+	case NAO_CS_HSY:
+		hsyToRgb(src[x * 3], src[x * 3 + 1], src[x * 3 + 2], rgb[0], rgb[1], rgb[2]);
+		break;
+	case NAO_CS_Y:
+		rgb[0] = rgb[1] = rgb[2] = src[x];
+		break;
+	default:
+	{
+		const uchar *pair = src + (x & ~1) * 2;
+		yuvToRgb(src[x * 2], pair[1], pair[3], rgb[0], rgb[1], rgb[2]);
+		break;
+	}
+	}
+}
+
+static bool matchesReference(int colorSpace, const std::vector<uchar> &src, int width, int height, const QImage &image)
+{
+	int stride = width * bytesPerPixel(colorSpace);
+	bool rgb32 = image.format() == QImage::Format_RGB32;
+	for (int y = 0; y < height; y++)
+	{
+		const uchar *line = image.constScanLine(y);
+		for (int x = 0; x < width; x++)
+		{
+			uchar rgb[3];
+			referencePixel(colorSpace, &src[y * stride], x, rgb);
+			const uchar *p = line + x * (rgb32 ? 4 : 3);
+			bool same = rgb32 ? (p[2] == rgb[0] && p[1] == rgb[1] && p[0] == rgb[2] && p[3] == 0xff)
+							  : (p[0] == rgb[0] && p[1] == rgb[1] && p[2] == rgb[2]);
+			if (!same)
+			{
+				fprintf(stderr, "mismatch at %d,%d of %dx%d\n", x, y, width, height);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Average usec per call of the best of BENCH_RUNS timed runs
+template <class Function>
+static double benchmark(Function &function)
+{
+	double best = 0;
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		int calls = 0;
+		long long start = naoTestClockUSecs();
+		long long elapsed = 0;
+		do
+		{
+			function();
+			calls++;
+			elapsed = naoTestClockUSecs() - start;
+		}
+		while (elapsed < BENCH_RUN_USECS);
+		double perCall = (double) elapsed / calls;
+		if (run == 0 || perCall < best)
+			best = perCall;
+	}
+	return best;
+}
+
+struct ViewerConversion
+{
+	const uchar *src;
+	int width;
+	int height;
+	int colorSpace;
+	QImage *dst;
+	void operator()() { convertCameraFrame(src, width, height, colorSpace, *dst); }
+};
+
+struct OpenCVConversion
+{
+	cv::Mat src;
+	cv::Mat dst;
+	int code;
+	void operator()()
+	{
+		if (code < 0)
+			src.copyTo(dst);
+		else
+			cv::cvtColor(src, dst, code);
+	}
+};
+
+// Every kernel, SIMD or not, against the per pixel reference. The odd
+// sizes exercise the scalar tails after the vector loops.
+NAO_TEST(pixel_conversion)
+{
+	static const int sizes[][2] = { { 320, 240 }, { 160, 120 }, { 38, 5 }, { 2, 1 } };
+	std::vector<uchar> src;
+	for (int c = 0; c < CASE_COUNT; c++)
+	{
+		for (int s = 0; s < 4; s++)
+		{
+			int width = sizes[s][0];
+			int height = sizes[s][1];
+			fillSource(src, width * height * bytesPerPixel(s_cases[c].colorSpace));
+			QImage image;
+			NAO_CHECK(convertCameraFrame(&src[0], width, height, s_cases[c].colorSpace, image));
+			NAO_CHECK(image.width() == width && image.height() == height);
+			NAO_CHECK(image.format() == cameraImageFormat(s_cases[c].colorSpace));
+			NAO_CHECK(matchesReference(s_cases[c].colorSpace, src, width, height, image));
+		}
+	}
+
+	// the destination is kept while the geometry stays the same
+	QImage image;
+	fillSource(src, 320 * 240 * 3);
+	convertCameraFrame(&src[0], 320, 240, NAO_CS_RGB, image);
+	const uchar *bits = image.constBits();
+	convertCameraFrame(&src[0], 320, 240, NAO_CS_BGR, image);
+	NAO_CHECK(image.constBits() == bits);
+	NAO_CHECK(!convertCameraFrame(NULL, 320, 240, NAO_CS_RGB, image));
+}
+
+// Throughput of each viewer kernel next to the cvtColor conversion doing
+// the same job, at the camera resolutions. Only reported, never fails:
+// the numbers depend on the machine.
+NAO_TEST(pixel_conversion_bench)
+{
+	static const int resolutions[] = { NAO_RES_QVGA, NAO_RES_VGA, NAO_RES_4VGA };
+
+	printf("%-16s %-10s %10s %10s %12s %8s  %s\n", "conversion", "size", "viewer us", "Mpixel/s", "cvtColor us", "cv/viewer", "cvtColor code");
+	std::vector<uchar> src;
+	for (int c = 0; c < CASE_COUNT; c++)
+	{
+		for (int r = 0; r < 3; r++)
+		{
+			int width = NaoInterface::resolutionWidth(resolutions[r]);
+			int height = NaoInterface::resolutionHeight(resolutions[r]);
+			int layers = bytesPerPixel(s_cases[c].colorSpace);
+			fillSource(src, width * height * layers);
+
+			QImage image;
+			ViewerConversion viewer = { &src[0], width, height, s_cases[c].colorSpace, &image };
+			double viewerUSecs = benchmark(viewer);
+
+			OpenCVConversion opencv;
+			opencv.src = cv::Mat(height, width, CV_8UC(layers), &src[0]);
+			opencv.code = s_cases[c].cvCode;
+			double opencvUSecs = benchmark(opencv);
+
+			char size[32];
+			sprintf(size, "%dx%d", width, height);
+			printf("%-16s %-10s %10.1f %10.1f %12.1f %8.2f  %s\n", s_cases[c].name, size, viewerUSecs,
+				   width * height / viewerUSecs, opencvUSecs, opencvUSecs / viewerUSecs, s_cases[c].cvName);
+			NAO_CHECK(viewerUSecs > 0);
+		}
+	}
+}
@@ -0,0 +1,170 @@
+/**
+ * Adaptive quality ladder and its behaviour on a simulated link
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <cstdio>
+
+#include "nao_interface.h"
+#include "qualitycontroller.h"
+
+static int bytesPerPixel(int colorSpace)
+{
+	switch (colorSpace)
+	{
+	case NAO_CS_YUV422:	return 2;
+	case NAO_CS_Y:		return 1;
+	default:			return 3;
+	}
+}
+
+static int frameBytes(const QualityController::Setting &setting)
+{
+	return NaoInterface::resolutionWidth(setting.resolution) * NaoInterface::resolutionHeight(setting.resolution)
+			* bytesPerPixel(setting.colorSpace);
+}
+
+static bool sameSetting(const QualityController::Setting &a, const QualityController::Setting &b)
+{
+	return a.resolution == b.resolution && a.colorSpace == b.colorSpace && a.fps == b.fps;
+}
+
+// One phase of the scripted link: getImageRemote takes the latency plus
+// the frame's bytes at the given bandwidth.
+struct LinkPhase
+{
+	int			seconds;
+	double		bytesPerSecond;
+	int			latencyUSecs;
+};
+
+struct LinkResult
+{
+	int			changes;
+	int			maxLevel;
+	int			endLevel;
+	int			lastChangeUSecs;	// from the start of the phase, -1 for none
+};
+
+// Runs the controller against one phase the way the viewer does: frames
+// are polled at the subscribed rate, a slow transfer delays the next poll.
+static LinkResult runPhase(QualityController &quality, const LinkPhase &phase)
+{
+	LinkResult result = { 0, quality.level(), quality.level(), -1 };
+	long long now = 0;
+	while (now < phase.seconds * 1000000LL)
+	{
+		QualityController::Setting setting = quality.currentSetting();
+		int bytes = frameBytes(setting);
+		int roundTrip = phase.latencyUSecs + (int)(bytes * 1000000.0 / phase.bytesPerSecond);
+		if (quality.addFrame(roundTrip, bytes))
+		{
+			result.changes++;
+			result.lastChangeUSecs = (int) now;
+		}
+		if (quality.level() > result.maxLevel)
+			result.maxLevel = quality.level();
+		int interval = 1000000 / setting.fps;
+		now += roundTrip > interval ? roundTrip : interval;
+	}
+	result.endLevel = quality.level();
+	return result;
+}
+
+// Every base gives a ladder that starts at the base, gets cheaper with
+// every rung and never repeats a setting.
+NAO_TEST(quality_ladder)
+{
+	for (int resolution = NAO_RES_QQVGA; resolution <= NAO_RES_4VGA; resolution++)
+	{
+		for (int colorSpace = NAO_CS_RGB; colorSpace <= NAO_CS_HSY; colorSpace++)
+		{
+			QualityController::Setting base = { resolution, colorSpace, CAMERA_FPS };
+			QualityController quality;
+			quality.setEnabled(true);
+			quality.reset(base);
+			NAO_CHECK(sameSetting(quality.currentSetting(), base));
+
+			// walk down the ladder on a link whose latency alone congests it
+			LinkPhase congested = { 600, 10.0 * 1024 * 1024, 500000 };
+			runPhase(quality, congested);
+			NAO_CHECK(quality.level() == quality.levelCount() - 1);
+
+			quality.reset(base);
+			QualityController::Setting previous = quality.currentSetting();
+			for (int level = 1; level < quality.levelCount(); level++)
+			{
+				LinkPhase step = { 4, 10.0 * 1024 * 1024, 500000 };
+				while (quality.level() < level)
+					runPhase(quality, step);
+				QualityController::Setting setting = quality.currentSetting();
+				NAO_CHECK(!sameSetting(setting, previous));
+				NAO_CHECK(setting.resolution <= previous.resolution);
+				NAO_CHECK(bytesPerPixel(setting.colorSpace) <= bytesPerPixel(previous.colorSpace));
+				NAO_CHECK(setting.fps <= previous.fps);
+				previous = setting;
+			}
+		}
+	}
+
+	// a base that is already two byte YUV has no color space step
+	QualityController::Setting rgb = { NAO_RES_QVGA, NAO_CS_RGB, CAMERA_FPS };
+	QualityController::Setting yuv = { NAO_RES_QVGA, NAO_CS_YUV422, CAMERA_FPS };
+	QualityController::Setting y = { NAO_RES_QQVGA, NAO_CS_Y, CAMERA_FPS };
+	QualityController quality;
+	quality.reset(rgb);
+	NAO_CHECK(quality.levelCount() == 6);
+	quality.reset(yuv);
+	NAO_CHECK(quality.levelCount() == 5);
+	quality.reset(y);
+	NAO_CHECK(quality.levelCount() == 3);
+}
+
+// Scripted link: fast, then congested, then fast again. The controller has
+// to step down while congested, settle without oscillating, and climb back
+// to the user's setting once the link recovers.
+NAO_TEST(quality_simulated_link)
+{
+	LinkPhase fast = { 30, 10.0 * 1024 * 1024, 5000 };
+	LinkPhase congested = { 120, 1024 * 1024, 5000 };
+	LinkPhase recovered = { 120, 10.0 * 1024 * 1024, 5000 };
+
+	QualityController::Setting base = { NAO_RES_QVGA, NAO_CS_RGB, CAMERA_FPS };
+	QualityController quality;
+	quality.setEnabled(true);
+	quality.reset(base);
+
+	LinkResult result = runPhase(quality, fast);
+	printf("fast:       %d changes, level %d\n", result.changes, result.endLevel);
+	NAO_CHECK(result.changes == 0);
+	NAO_CHECK(result.endLevel == 0);
+
+	result = runPhase(quality, congested);
+	printf("congested:  %d changes, max level %d, end level %d, last change at %.1f s\n",
+		   result.changes, result.maxLevel, result.endLevel, result.lastChangeUSecs / 1000000.0);
+	NAO_CHECK(result.endLevel > 0);
+	// the settled rung fits the link with the congestion margin
+	QualityController::Setting settled = quality.currentSetting();
+	double roundTrip = congested.latencyUSecs + frameBytes(settled) * 1000000.0 / congested.bytesPerSecond;
+	NAO_CHECK(roundTrip < 0.7 * 1000000.0 / settled.fps);
+	// no oscillation: every change is a step down, and it settles early
+	NAO_CHECK(result.changes == result.maxLevel);
+	NAO_CHECK(result.endLevel == result.maxLevel);
+	NAO_CHECK(result.lastChangeUSecs < 30 * 1000000);
+	int congestedLevel = result.endLevel;
+
+	result = runPhase(quality, recovered);
+	printf("recovered:  %d changes, end level %d, last change at %.1f s\n",
+		   result.changes, result.endLevel, result.lastChangeUSecs / 1000000.0);
+	NAO_CHECK(result.endLevel == 0);
+	NAO_CHECK(result.changes == congestedLevel);
+	NAO_CHECK(result.lastChangeUSecs < 60 * 1000000);
+
+	// a controller that is switched off never changes anything
+	quality.setEnabled(false);
+	quality.reset(base);
+	result = runPhase(quality, congested);
+	NAO_CHECK(result.changes == 0 && result.endLevel == 0);
+}
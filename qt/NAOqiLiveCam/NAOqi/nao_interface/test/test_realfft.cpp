@@ -0,0 +1,141 @@
+/**
+ * Spectrum FFT: output check against a direct DFT and throughput
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "realfft.h"
+
+static const int BENCH_RUNS = 5;
+static const long long BENCH_RUN_USECS = 200000;
+
+// The window RealFFT applies: Hann, scaled so a full scale sine peaks at 1
+static void hannWindow(int size, std::vector<double> &window)
+{
+	window.resize(size);
+	double sum = 0;
+	for (int i = 0; i < size; i++)
+	{
+		window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / (size - 1));
+		sum += window[i];
+	}
+	for (int i = 0; i < size; i++)
+		window[i] *= 2.0 / sum;
+}
+
+// Windowed DFT magnitudes of the first size/2 bins, straight from the definition
+static void directMagnitudes(const std::vector<float> &input, std::vector<double> &output)
+{
+	int size = input.size();
+	std::vector<double> window;
+	hannWindow(size, window);
+	output.resize(size / 2);
+	for (int k = 0; k < size / 2; k++)
+	{
+		double re = 0;
+		double im = 0;
+		for (int n = 0; n < size; n++)
+		{
+			double angle = -2.0 * M_PI * ((long long) k * n % size) / size;
+			re += input[n] * window[n] * cos(angle);
+			im += input[n] * window[n] * sin(angle);
+		}
+		output[k] = sqrt(re * re + im * im);
+	}
+}
+
+static void fillSignal(std::vector<float> &signal, int size)
+{
+	signal.resize(size);
+	unsigned int seed = 4321;
+	for (int i = 0; i < size; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		float noise = (float)((seed >> 16) & 0x7fff) / 0x7fff - 0.5f;
+		signal[i] = 0.5f * (float) sin(2.0 * M_PI * 5.3 * i / size) + 0.2f * noise;
+	}
+}
+
+// Every size the spectrum view may use, from the smallest the SSE stages
+// handle to more than a frame of audio.
+NAO_TEST(realfft)
+{
+	std::vector<float> signal;
+	std::vector<float> fast;
+	std::vector<double> direct;
+	for (int size = 16; size <= 4096; size *= 2)
+	{
+		fillSignal(signal, size);
+		fast.resize(size / 2);
+		RealFFT fft(size);
+		NAO_CHECK(fft.size() == size);
+		fft.magnitudes(&signal[0], &fast[0]);
+		directMagnitudes(signal, direct);
+
+		double worst = 0;
+		for (int k = 0; k < size / 2; k++)
+			worst = std::max(worst, fabs(fast[k] - direct[k]));
+		if (worst > 1e-4)
+			fprintf(stderr, "size %d: largest difference %g\n", size, worst);
+		NAO_CHECK(worst <= 1e-4);
+	}
+
+	// a full scale sine centered on a bin reads 1.0 there
+	const int size = 1024;
+	const int bin = 37;
+	signal.resize(size);
+	for (int i = 0; i < size; i++)
+		signal[i] = (float) sin(2.0 * M_PI * bin * i / size);
+	fast.resize(size / 2);
+	RealFFT fft(size);
+	fft.magnitudes(&signal[0], &fast[0]);
+	NAO_CHECK(fabs(fast[bin] - 1.0f) < 0.01f);
+	NAO_CHECK(fast[bin + 4] < 0.001f && fast[bin - 4] < 0.001f);
+}
+
+// Transform time per size, next to the direct DFT for scale. Only
+// reported: the numbers depend on the machine.
+NAO_TEST(realfft_bench)
+{
+	printf("%6s %12s %14s %14s\n", "size", "fft us", "transforms/s", "direct dft us");
+	std::vector<float> signal;
+	std::vector<float> output;
+	std::vector<double> direct;
+	for (int size = 256; size <= 4096; size *= 2)
+	{
+		fillSignal(signal, size);
+		output.resize(size / 2);
+		RealFFT fft(size);
+
+		double best = 0;
+		for (int run = 0; run < BENCH_RUNS; run++)
+		{
+			int calls = 0;
+			long long start = naoTestClockUSecs();
+			long long elapsed = 0;
+			do
+			{
+				fft.magnitudes(&signal[0], &output[0]);
+				calls++;
+				elapsed = naoTestClockUSecs() - start;
+			}
+			while (elapsed < BENCH_RUN_USECS);
+			double perCall = (double) elapsed / calls;
+			if (run == 0 || perCall < best)
+				best = perCall;
+		}
+
+		long long start = naoTestClockUSecs();
+		directMagnitudes(signal, direct);
+		long long directUSecs = naoTestClockUSecs() - start;
+
+		printf("%6d %12.2f %14.0f %14lld\n", size, best, 1000000.0 / best, directUSecs);
+		NAO_CHECK(best > 0);
+	}
+}
@@ -0,0 +1,293 @@
+/**
+ * Long running soak of capture, audio and reconnects against a robot
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+
+#include "nao_interface.h"
+
+// Every operator new in the process is counted, the library's included.
+// OpenCV's own allocator bypasses it; the RSS covers that memory. The
+// soak has a binary of its own so that the counting does not slow down
+// the other cases and benchmarks.
+static volatile long s_allocations = 0;
+static volatile long s_frees = 0;
+
+#if __cplusplus >= 201103L
+#define NAO_THROW_BAD_ALLOC
+#define NAO_THROW_NOTHING	noexcept
+#else
+#define NAO_THROW_BAD_ALLOC	throw(std::bad_alloc)
+#define NAO_THROW_NOTHING	throw()
+#endif
+
+void* operator new(size_t size) NAO_THROW_BAD_ALLOC
+{
+	__sync_fetch_and_add(&s_allocations, 1);
+	void *p = malloc(size ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) NAO_THROW_BAD_ALLOC
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) NAO_THROW_NOTHING
+{
+	if (p == NULL)
+		return;
+	__sync_fetch_and_add(&s_frees, 1);
+	free(p);
+}
+
+void operator delete[](void *p) NAO_THROW_NOTHING
+{
+	operator delete(p);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void *p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	operator delete(p);
+}
+#endif
+
+static const int AUDIO_BLOCK_SAMPLES = 1024;
+static const int AUDIO_GAP_EVERY = 10;		// one block in so many is lost on the "link"
+
+class CountingAudioSink : public NAOqiToPCAudioInterface
+{
+public:
+	CountingAudioSink() : samples(0) {}
+	virtual void writeData(const short *, int count, int) { samples += count; }
+	long long samples;
+};
+
+struct SoakSample
+{
+	double		minutes;
+	long		rssKBytes;
+	long		liveAllocations;
+	long		allocationsPerSecond;
+	int			threads;
+	int			captureP50USecs;
+	int			captureP99USecs;
+	int			audioP99USecs;
+	int			connectUSecs;
+};
+
+static long residentKBytes()
+{
+	long size = 0;
+	long resident = 0;
+	FILE *file = fopen("/proc/self/statm", "r");
+	if (file == NULL)
+		return 0;
+	if (fscanf(file, "%ld %ld", &size, &resident) != 2)
+		resident = 0;
+	fclose(file);
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int threadCount()
+{
+	int threads = 0;
+	FILE *file = fopen("/proc/self/status", "r");
+	if (file == NULL)
+		return 0;
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		if (sscanf(line, "Threads: %d", &threads) == 1)
+			break;
+	}
+	fclose(file);
+	return threads;
+}
+
+static int percentile(std::vector<int> &values, int percent)
+{
+	if (values.empty())
+		return 0;
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size() - 1, values.size() * percent / 100)];
+}
+
+static void printSample(const SoakSample &sample)
+{
+	printf("%7.1f %9ld %11ld %10ld %8d %9d %9d %9d %10.1f\n", sample.minutes, sample.rssKBytes / 1024,
+		   sample.liveAllocations, sample.allocationsPerSecond, sample.threads, sample.captureP50USecs,
+		   sample.captureP99USecs, sample.audioP99USecs, sample.connectUSecs / 1000.0);
+	fflush(stdout);
+}
+
+// Hours of what a viewer session does to the library: connect, stream the
+// camera at full demand and the robot's audio, move the head, disconnect,
+// and again. The robot's audio module feeds audioReceived() while
+// connected, so the audio path with the odd lost block is played between
+// connections, where it is the only stream. The state is sampled at the
+// end of every cycle, so all samples see the same threads and buffers. The
+// first sample after the warm-up (longer than the replay ring takes to
+// fill) is the baseline; the run fails when the last sample drifts past it
+// by more than the thresholds.
+//     nao_soak_test soak --robot 127.0.0.1 [--minutes 120] [--warmup 120]
+//          [--cycle 30] [--audio 5] [--rss-mb 16] [--allocations 2000]
+//          [--threads 0] [--p99-ratio 2]
+// Use a local simulated NAOqi (naoqi-bin or a Choregraphe virtual robot) to
+// run it without hardware.
+NAO_MANUAL_TEST(soak)
+{
+	std::string robot = naoTestStringOption(argc, argv, "robot", "127.0.0.1");
+	double minutes = naoTestOption(argc, argv, "minutes", 120);
+	double warmupSeconds = naoTestOption(argc, argv, "warmup", 120);
+	double cycleSeconds = naoTestOption(argc, argv, "cycle", 30);
+	double audioSeconds = naoTestOption(argc, argv, "audio", 5);
+	double maxRssGrowthMBytes = naoTestOption(argc, argv, "rss-mb", 16);
+	double maxAllocationGrowth = naoTestOption(argc, argv, "allocations", 2000);
+	double maxThreadGrowth = naoTestOption(argc, argv, "threads", 0);
+	double maxP99Ratio = naoTestOption(argc, argv, "p99-ratio", 2);
+
+	NaoInterface *nao = NaoInterface::instance();
+	CountingAudioSink sink;
+	nao->setAudioInterface(&sink);
+	nao->setReplayBuffer(REPLAY_SECONDS, REPLAY_MAX_BYTES);
+	nao->setFrameDemand(NAO_CONSUMER_VIEW, NAO_DEMAND_FULL);
+
+	std::vector<short> audio(AUDIO_BLOCK_SAMPLES);
+	for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+		audio[i] = (short)((i * 37) % 2000 - 1000);
+	const long long blockUSecs = AUDIO_BLOCK_SAMPLES * 1000000LL / SAMPLERATE_IN;
+
+	printf("%7s %9s %11s %10s %8s %9s %9s %9s %10s\n", "minutes", "rss MB", "live allocs", "allocs/s", "threads",
+		   "cap p50", "cap p99", "audio p99", "connect ms");
+
+	std::vector<SoakSample> samples;
+	bool haveBaseline = false;
+	SoakSample baseline = SoakSample();
+	long long start = naoTestClockUSecs();
+	long long end = start + (long long)(minutes * 60 * 1000000);
+	long long robotSamples = 0;
+	int cycle = 0;
+	bool connected = true;
+	while (connected && naoTestClockUSecs() < end)
+	{
+		long long connectStart = naoTestClockUSecs();
+		try
+		{
+			nao->setNaoIp(robot);
+		}
+		catch (const std::string &error)
+		{
+			fprintf(stderr, "cannot connect to %s: %s\n", robot.c_str(), error.c_str());
+			connected = false;
+			break;
+		}
+		int connectUSecs = (int)(naoTestClockUSecs() - connectStart);
+		long allocationsBefore = s_allocations;
+		long long samplesBefore = sink.samples;
+
+		std::vector<int> captureUSecs;
+		long long cycleStart = naoTestClockUSecs();
+		while (naoTestClockUSecs() - cycleStart < (long long)(cycleSeconds * 1000000))
+		{
+			long long frameStart = naoTestClockUSecs();
+			nao->updateCameraView();
+			captureUSecs.push_back((int)(naoTestClockUSecs() - frameStart));
+
+			float yaw = (float)(captureUSecs.size() % 40) / 40.0f - 0.5f;
+			nao->setHeadTarget(yaw, 0.0f);
+
+			int fps = std::max(1, nao->subscribedFrameRate());
+			long long wait = 1000000 / fps - (naoTestClockUSecs() - frameStart);
+			if (wait > 0)
+				usleep((useconds_t) wait);
+		}
+		robotSamples += sink.samples - samplesBefore;
+		nao->disconnect();
+
+		// disconnected, the received audio comes from here alone: in real
+		// time, with a lost block now and then
+		std::vector<int> audioUSecs;
+		long long audioStart = naoTestClockUSecs();
+		long long audioTimestamp = audioStart;
+		long long nextAudio = audioStart;
+		for (int block = 1; nextAudio - audioStart < (long long)(audioSeconds * 1000000); block++)
+		{
+			long long wait = nextAudio - naoTestClockUSecs();
+			if (wait > 0)
+				usleep((useconds_t) wait);
+			if (block % AUDIO_GAP_EVERY == 0)
+				audioTimestamp += blockUSecs;
+			long long before = naoTestClockUSecs();
+			nao->audioReceived(&audio[0], AUDIO_BLOCK_SAMPLES, audioTimestamp);
+			audioUSecs.push_back((int)(naoTestClockUSecs() - before));
+			audioTimestamp += blockUSecs;
+			nextAudio += blockUSecs;
+		}
+		// the next connection starts a new stream
+		nao->disconnect();
+
+		SoakSample sample;
+		long long now = naoTestClockUSecs();
+		sample.minutes = (now - start) / 60000000.0;
+		sample.rssKBytes = residentKBytes();
+		sample.liveAllocations = s_allocations - s_frees;
+		sample.allocationsPerSecond = (long)((s_allocations - allocationsBefore) / (cycleSeconds + audioSeconds));
+		sample.threads = threadCount();
+		sample.captureP50USecs = percentile(captureUSecs, 50);
+		sample.captureP99USecs = percentile(captureUSecs, 99);
+		sample.audioP99USecs = percentile(audioUSecs, 99);
+		sample.connectUSecs = connectUSecs;
+		samples.push_back(sample);
+		printSample(sample);
+
+		if (!haveBaseline && now - start >= (long long)(warmupSeconds * 1000000))
+		{
+			baseline = sample;
+			haveBaseline = true;
+		}
+		cycle++;
+	}
+	nao->setAudioInterface(NULL);
+	printf("%lld samples of robot audio received\n", robotSamples);
+
+	NAO_CHECK(connected);
+	NAO_CHECK(sink.samples > 0);
+	if (!haveBaseline || samples.size() < 2)
+	{
+		fprintf(stderr, "run too short for a baseline after %g s of warm-up\n", warmupSeconds);
+		NAO_CHECK(haveBaseline && samples.size() >= 2);
+		return;
+	}
+
+	const SoakSample &last = samples.back();
+	printf("%d cycles, drift since the baseline at %.1f minutes:\n", cycle, baseline.minutes);
+	printf("  rss %+ld kB, live allocations %+ld, threads %+d, capture p99 %d -> %d us, audio p99 %d -> %d us\n",
+		   last.rssKBytes - baseline.rssKBytes, last.liveAllocations - baseline.liveAllocations,
+		   last.threads - baseline.threads, baseline.captureP99USecs, last.captureP99USecs,
+		   baseline.audioP99USecs, last.audioP99USecs);
+
+	NAO_CHECK(last.rssKBytes - baseline.rssKBytes <= maxRssGrowthMBytes * 1024);
+	NAO_CHECK(last.liveAllocations - baseline.liveAllocations <= maxAllocationGrowth);
+	NAO_CHECK(last.threads - baseline.threads <= maxThreadGrowth);
+	// percentiles of a few ms are noisy, a millisecond of slack on top
+	NAO_CHECK(last.captureP99USecs <= baseline.captureP99USecs * maxP99Ratio + 1000);
+	NAO_CHECK(last.audioP99USecs <= baseline.audioP99USecs * maxP99Ratio + 1000);
+}
@@ -0,0 +1,136 @@
+/**
+ * Display rate of the preview loop while the detector load rises
+ * Created 2026/10/19
+ */
+
+#include "nao_test.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <opencv2/core/core.hpp>
+
+#include "vision_analyzer.h"
+
+static const int DISPLAY_FPS = 30;
+
+struct LoadLevel
+{
+	const char	*name;
+	int			resolution;		// -1 for analysis off
+};
+
+// The detectors' cost grows with the frame area
+static const LoadLevel s_levels[] =
+{
+	{ "off",	-1 },
+	{ "QQVGA",	NAO_RES_QQVGA },
+	{ "QVGA",	NAO_RES_QVGA },
+	{ "VGA",	NAO_RES_VGA },
+	{ "4VGA",	NAO_RES_4VGA }
+};
+static const int LEVEL_COUNT = sizeof(s_levels) / sizeof(s_levels[0]);
+
+struct DisplayResult
+{
+	double		displayFps;
+	int			frames;
+	int			submitMedianUSecs;
+	int			submitMaxUSecs;
+	long long	analyzed;
+	double		analysisFps;
+	int			analysisUSecs;
+	long long	dropped;
+	bool		ordered;		// detection time stamps only moved forward, to submitted frames
+};
+
+// Plays the viewer's capture loop for the given time: a frame every display
+// interval is handed to the analyzer, and the loop sleeps to the next tick.
+static DisplayResult runDisplayLoop(VisionAnalyzer *analyzer, const cv::Mat &frame, double seconds)
+{
+	const long long interval = 1000000 / DISPLAY_FPS;
+	std::vector<int> submitUSecs;
+	long long start = naoTestClockUSecs();
+	long long end = start + (long long)(seconds * 1000000);
+	long long nextTick = start;
+	int frames = 0;
+	long long timestamp = 0;
+	long long detectionTimestamp = 0;
+	bool ordered = true;
+	while (naoTestClockUSecs() < end)
+	{
+		long long before = naoTestClockUSecs();
+		if (analyzer)
+			analyzer->submit(frame, NAO_CS_RGB, timestamp);
+		submitUSecs.push_back((int)(naoTestClockUSecs() - before));
+		if (analyzer)
+		{
+			long long newest = 0;
+			analyzer->getDetections(NULL, 0, &newest);
+			if (newest < detectionTimestamp || newest > timestamp || newest % interval != 0)
+				ordered = false;
+			detectionTimestamp = newest;
+		}
+		frames++;
+		timestamp += interval;
+
+		// a late tick is not caught up, like the viewer's QTimer
+		nextTick = std::max(nextTick + interval, naoTestClockUSecs());
+		long long wait = nextTick - naoTestClockUSecs();
+		if (wait > 0)
+			usleep((useconds_t) wait);
+	}
+	long long elapsed = naoTestClockUSecs() - start;
+
+	DisplayResult result;
+	result.displayFps = frames * 1000000.0 / elapsed;
+	result.frames = frames;
+	result.ordered = ordered;
+	std::sort(submitUSecs.begin(), submitUSecs.end());
+	result.submitMedianUSecs = submitUSecs[submitUSecs.size() / 2];
+	result.submitMaxUSecs = submitUSecs.back();
+	NaoAnalysisStats stats = { 0, 0, 0 };
+	if (analyzer)
+		analyzer->getStats(stats);
+	result.analyzed = stats.analyzed;
+	result.analysisFps = stats.analyzed * 1000000.0 / elapsed;
+	result.analysisUSecs = stats.lastUSecs;
+	result.dropped = stats.dropped;
+	return result;
+}
+
+// The detector works on its own threads and only ever sees the newest
+// frame, so a heavier detection has to lower the analysis rate and not the
+// display rate. The rates are only reported, they depend on the machine and
+// its load; the case fails when a frame is counted twice or the results go
+// back in time or ahead of the submitted frames.
+//     vision_analyzer_display [--seconds 2] [--cascade haarcascade.xml]
+NAO_TEST(vision_analyzer_display)
+{
+	double seconds = naoTestOption(argc, argv, "seconds", 2);
+	std::string cascade = naoTestStringOption(argc, argv, "cascade", "");
+
+	printf("%-8s %12s %12s %12s %14s %12s %10s\n", "load", "display fps", "submit us", "submit max", "analysis fps",
+		   "analysis ms", "dropped");
+	for (int i = 0; i < LEVEL_COUNT; i++)
+	{
+		cv::Mat frame;
+		if (s_levels[i].resolution >= 0)
+		{
+			frame.create(NaoInterface::resolutionHeight(s_levels[i].resolution),
+						 NaoInterface::resolutionWidth(s_levels[i].resolution), CV_8UC3);
+			cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+		}
+		VisionAnalyzer *analyzer = s_levels[i].resolution >= 0 ? new VisionAnalyzer(cascade) : NULL;
+		DisplayResult result = runDisplayLoop(analyzer, frame, seconds);
+		delete analyzer;
+
+		printf("%-8s %12.1f %12d %12d %14.1f %12.1f %10lld\n", s_levels[i].name, result.displayFps,
+			   result.submitMedianUSecs, result.submitMaxUSecs, result.analysisFps, result.analysisUSecs / 1000.0,
+			   result.dropped);
+		NAO_CHECK(result.ordered);
+		NAO_CHECK(result.analyzed + result.dropped <= result.frames);
+	}
+}
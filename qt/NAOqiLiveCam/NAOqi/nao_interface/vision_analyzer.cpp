@@ -0,0 +1,162 @@
+/**
+ * Face and person detection on background threads
+ * Created 2026/10/19
+ */
+
+#include "vision_analyzer.h"
+#include "nao_time.h"
+
+#include <iostream>
+#include <algorithm>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+VisionAnalyzer::VisionAnalyzer(const std::string &faceCascadePath)
+	: m_threadCount(0)
+	, m_quit(false)
+	, m_faceCascadePath(faceCascadePath)
+	, m_pendingColorSpace(NAO_CS_RGB)
+	, m_pendingTimestamp(0)
+	, m_hasPending(false)
+	, m_detectionTimestamp(0)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_cond, NULL);
+	m_stats.analyzed = 0;
+	m_stats.dropped = 0;
+	m_stats.lastUSecs = 0;
+
+	for (int i = 0; i < ANALYSIS_THREADS; i++)
+	{
+		if (pthread_create(&m_threads[m_threadCount], NULL, workerEntry, this) == 0)
+			m_threadCount++;
+	}
+}
+
+VisionAnalyzer::~VisionAnalyzer()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_quit = true;
+	pthread_cond_broadcast(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+
+	for (int i = 0; i < m_threadCount; i++)
+		pthread_join(m_threads[i], NULL);
+
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void VisionAnalyzer::submit(const cv::Mat &frame, int colorSpace, long long timestamp)
+{
+	pthread_mutex_lock(&m_mutex);
+	if (m_hasPending)
+		m_stats.dropped++;
+	frame.copyTo(m_pending);
+	m_pendingColorSpace = colorSpace;
+	m_pendingTimestamp = timestamp;
+	m_hasPending = true;
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+int VisionAnalyzer::getDetections(NaoDetection *detections, int maxDetections, long long *timestamp) const
+{
+	pthread_mutex_lock(&m_mutex);
+	int count = std::min((int) m_detections.size(), maxDetections);
+	for (int i = 0; i < count; i++)
+		detections[i] = m_detections[i];
+	*timestamp = m_detectionTimestamp;
+	pthread_mutex_unlock(&m_mutex);
+	return count;
+}
+
+void VisionAnalyzer::getStats(NaoAnalysisStats &stats) const
+{
+	pthread_mutex_lock(&m_mutex);
+	stats = m_stats;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+//static
+void* VisionAnalyzer::workerEntry(void *arg)
+{
+	static_cast<VisionAnalyzer*>(arg)->workerLoop();
+	return NULL;
+}
+
+void VisionAnalyzer::workerLoop()
+{
+	// detectors are not shared between threads
+	cv::CascadeClassifier faceDetector;
+	bool hasFaceDetector = !m_faceCascadePath.empty() && faceDetector.load(m_faceCascadePath);
+	if (!m_faceCascadePath.empty() && !hasFaceDetector)
+		std::cerr << "Cannot load face cascade: " << m_faceCascadePath << std::endl;
+	cv::HOGDescriptor personDetector;
+	personDetector.setSVMDetector(cv::HOGDescriptor::getDefaultPeopleDetector());
+
+	cv::Mat frame;
+	cv::Mat gray;
+	std::vector<cv::Rect> faces;
+	std::vector<cv::Rect> people;
+	std::vector<NaoDetection> results;
+
+	pthread_mutex_lock(&m_mutex);
+	while (!m_quit)
+	{
+		if (!m_hasPending)
+		{
+			pthread_cond_wait(&m_cond, &m_mutex);
+			continue;
+		}
+
+		cv::swap(frame, m_pending);
+		int colorSpace = m_pendingColorSpace;
+		long long timestamp = m_pendingTimestamp;
+		m_hasPending = false;
+		pthread_mutex_unlock(&m_mutex);
+
+		long long start = getTimeUSecs();
+		switch (colorSpace)
+		{
+		case NAO_CS_RGB:	cv::cvtColor(frame, gray, CV_RGB2GRAY); break;
+		case NAO_CS_BGR:	cv::cvtColor(frame, gray, CV_BGR2GRAY); break;
+		case NAO_CS_YUV422:	cv::extractChannel(frame, gray, 0); break;
+		case NAO_CS_HSY:	cv::extractChannel(frame, gray, 2); break;
+		default:			frame.copyTo(gray); break;
+		}
+		cv::equalizeHist(gray, gray);
+
+		faces.clear();
+		people.clear();
+		if (hasFaceDetector)
+			faceDetector.detectMultiScale(gray, faces, 1.2, 3, 0, cv::Size(20, 20));
+		if (gray.rows >= 128)
+			personDetector.detectMultiScale(gray, people);
+
+		results.clear();
+		for (size_t i = 0; i < faces.size() + people.size(); i++)
+		{
+			const cv::Rect &r = i < faces.size() ? faces[i] : people[i - faces.size()];
+			NaoDetection detection;
+			detection.x = (float) r.x / gray.cols;
+			detection.y = (float) r.y / gray.rows;
+			detection.width = (float) r.width / gray.cols;
+			detection.height = (float) r.height / gray.rows;
+			detection.kind = i < faces.size() ? NAO_DETECT_FACE : NAO_DETECT_PERSON;
+			results.push_back(detection);
+		}
+		int elapsed = (int)(getTimeUSecs() - start);
+
+		pthread_mutex_lock(&m_mutex);
+		// with several workers an older frame may finish last
+		if (timestamp >= m_detectionTimestamp)
+		{
+			m_detections.swap(results);
+			m_detectionTimestamp = timestamp;
+		}
+		m_stats.analyzed++;
+		m_stats.lastUSecs = elapsed;
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
@@ -0,0 +1,59 @@
+/**
+ * Face and person detection on background threads
+ * Created 2026/10/19
+ */
+
+#ifndef VISION_ANALYZER_H
+#define VISION_ANALYZER_H
+
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <opencv2/core/core.hpp>
+
+#include "nao_interface.h"
+
+/**
+ * Face / person detection running on its own threads. submit() only copies
+ * the frame into a single "newest" slot: a frame still waiting there when
+ * the next one arrives is dropped, so the detector always works on the most
+ * recent image and never holds up the display. Results carry the camera
+ * time stamp of the frame they were computed on.
+ */
+class VisionAnalyzer
+{
+public:
+	VisionAnalyzer(const std::string &faceCascadePath);
+	~VisionAnalyzer();
+
+	void	submit(const cv::Mat &frame, int colorSpace, long long timestamp);
+
+	int		getDetections(NaoDetection *detections, int maxDetections, long long *timestamp) const;
+	void	getStats(NaoAnalysisStats &stats) const;
+
+private:
+	enum { ANALYSIS_THREADS = 2 };
+
+	static void*	workerEntry(void *arg);
+	void			workerLoop();
+
+private:
+	mutable pthread_mutex_t		m_mutex;
+	pthread_cond_t				m_cond;
+	pthread_t					m_threads[ANALYSIS_THREADS];
+	int							m_threadCount;
+	bool						m_quit;
+	std::string					m_faceCascadePath;
+
+	// newest frame waiting for a worker
+	cv::Mat						m_pending;
+	int							m_pendingColorSpace;
+	long long					m_pendingTimestamp;
+	bool						m_hasPending;
+
+	std::vector<NaoDetection>	m_detections;
+	long long					m_detectionTimestamp;
+	NaoAnalysisStats			m_stats;
+};
+
+#endif // VISION_ANALYZER_H
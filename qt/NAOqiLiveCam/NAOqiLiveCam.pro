@@ -14,10 +14,22 @@ TEMPLATE = app
 
 SOURCES += main.cpp\
         mainwindow.cpp \
-    audiooutput.cpp
+    audiooutput.cpp \
+    snapshotcapture.cpp \
+    pixelconversion.cpp \
+    qualitycontroller.cpp \
+    realfft.cpp \
+    audiospectrum.cpp \
+    spectrumwidget.cpp
 
 HEADERS  += mainwindow.h NAOqi/nao_interface/nao_interface.h \
-    audiooutput.h
+    audiooutput.h \
+    snapshotcapture.h \
+    pixelconversion.h \
+    qualitycontroller.h \
+    realfft.h \
+    audiospectrum.h \
+    spectrumwidget.h
 
 FORMS    += mainwindow.ui
 
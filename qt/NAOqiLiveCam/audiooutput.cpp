@@ -6,15 +6,20 @@
 #include <QDebug>
 #include <QAudioOutput>
 #include <QAudioDeviceInfo>
-#include <QMutex>
+#include <string.h>
 #include "audiooutput.h"
 
-static QMutex tmutex;
+static const int UNDERRUN_CHUNK_MSEC = 20;
+static const int NOTIFY_INTERVAL_MSEC = 20;
+static const int BYTES_PER_SECOND = SAMPLERATE_OUT * NBOFOUTPUTCHANNELS_OUT * CHANNELBYTES;
 
 AudioOutput::AudioOutput()
     :   m_device(QAudioDeviceInfo::defaultOutputDevice())
     ,   m_audioOutput(0)
-    ,   m_outputDevice(0)
+    ,   m_buffer(0)
+    ,   m_bufferSize(0)
+    ,   m_deviceLatencyUSecs(0)
+    ,   m_liveMuted(0)
 {
     initializeAudio();
 
@@ -39,10 +44,10 @@ void AudioOutput::initializeAudio()
         m_format = info.nearestFormat(m_format);
     }
 
-    createAudioOutput();
+    m_buffer = new AudioOutputBuffer();
+    setUnderrunChunkMsec(UNDERRUN_CHUNK_MSEC);
 
-    m_workderThread = new AudioOutputWorkerThread();
-    m_workderThread->start();
+    createAudioOutput();
 }
 
 void AudioOutput::createAudioOutput()
@@ -53,11 +58,20 @@ void AudioOutput::createAudioOutput()
         delete m_audioOutput;
     m_audioOutput = 0;
     m_audioOutput = new QAudioOutput(m_device, m_format, this);
+    if (m_bufferSize > 0)
+        m_audioOutput->setBufferSize(m_bufferSize);
+    m_audioOutput->setNotifyInterval(NOTIFY_INTERVAL_MSEC);
+    connect(m_audioOutput, SIGNAL(stateChanged(QAudio::State)), this, SLOT(stateChanged(QAudio::State)));
+    connect(m_audioOutput, SIGNAL(notify()), this, SLOT(notified()));
 }
 
 AudioOutput::~AudioOutput()
 {
-    delete m_workderThread;
+    NaoInterface::instance()->setAudioInterface(NULL);
+
+    if (m_audioOutput)
+        m_audioOutput->stop();
+    delete m_buffer;
 }
 
 void AudioOutput::deviceChanged(int index)
@@ -74,112 +88,231 @@ void AudioOutput::stateChanged(QAudio::State state)
     qWarning() << "state = " << state;
 }
 
+void AudioOutput::notified()
+{
+    // bytes handed to the device but not yet played
+    qint64 deliveredUSecs = m_buffer->bytesDelivered() * 1000000 / BYTES_PER_SECOND;
+    m_deviceLatencyUSecs = deliveredUSecs - m_audioOutput->processedUSecs();
+}
+
 void AudioOutput::startPlay()
 {
-    m_workderThread->setOutputDevice(NULL);
-    m_outputDevice = m_audioOutput->start();
-    m_workderThread->setOutputDevice(m_outputDevice);
+    m_audioOutput->stop();
+
+    m_buffer->close();
+    m_buffer->clear();
+    // unbuffered: QIODevice's read ahead would hold audio the reported
+    // latency does not count
+    m_buffer->open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    m_deviceLatencyUSecs = 0;
+    m_audioOutput->start(m_buffer);
 }
 
 void AudioOutput::stopPlay()
 {
+    m_audioOutput->stop();
+    m_buffer->close();
+    m_buffer->clear();
+}
+
+void AudioOutput::setBufferSize(int bytes)
+{
+    if (bytes == m_bufferSize)
+        return;
+
+    // a device only takes the size before it starts, and going back to
+    // the backend default needs a fresh one
+    m_bufferSize = bytes;
     m_audioOutput->stop();
     m_audioOutput->disconnect(this);
+    createAudioOutput();
 }
 
-void AudioOutput::writeData(const short *data, int samples)
+void AudioOutput::setUnderrunChunkMsec(int msec)
 {
-    if (m_workderThread)
-    {
-        m_workderThread->writeAudioBuffer(data, samples);
-    }
+    m_buffer->setUnderrunBytes(BYTES_PER_SECOND * msec / 1000);
 }
 
+qint64 AudioOutput::outputLatencyUSecs() const
+{
+    return (qint64) m_buffer->bytesQueued() * 1000000 / BYTES_PER_SECOND + m_deviceLatencyUSecs;
+}
 
+int AudioOutput::bytesFree() const
+{
+    return m_audioOutput ? m_audioOutput->bytesFree() : 0;
+}
 
-AudioOutputWorkerThread::AudioOutputWorkerThread() : m_quit(false), m_outputDevice(0)
+int AudioOutput::droppedSamples() const
 {
-    m_buffers[0] = new char[CHANNELBYTES * NBOFOUTPUTCHANNELS_OUT * SAMPLERATE_OUT * BUFFERSAMPLESIZEMSEC / 1000];
-    m_buffers[1] = new char[CHANNELBYTES * NBOFOUTPUTCHANNELS_OUT * SAMPLERATE_OUT * BUFFERSAMPLESIZEMSEC / 1000];
-    m_numSamples = 0;
+    return m_buffer->droppedSamples();
 }
 
-AudioOutputWorkerThread::~AudioOutputWorkerThread()
+void AudioOutput::writeData(const short *data, int samples, int concealedSamples)
 {
-    m_quit = true;
-    m_sem.release();
-    wait(5000);
+    m_spectrum.write(data, samples);
+    if (m_liveMuted.fetchAndAddAcquire(0) == 0)
+        m_buffer->push(data, samples, concealedSamples);
+}
 
-    tmutex.lock();
-    for (int i = 0; i < 2; i++)
-    {
-        if (m_buffers[i])
-        {
-            delete m_buffers[i];
-            m_buffers[i] = NULL;
-        }
-    }
-    tmutex.unlock();
+void AudioOutput::setLiveMuted(bool muted)
+{
+    m_liveMuted.fetchAndStoreRelease(muted ? 1 : 0);
+    // whatever is queued belongs to the other stream
+    m_buffer->discard();
 }
 
-void AudioOutputWorkerThread::run()
+void AudioOutput::writeReplayData(const short *data, int samples)
 {
-    while(!m_quit)
-    {
-        m_sem.acquire();
-        if (!m_quit)
-        {
-            if (m_outputDevice)
-            {
-                memcpy(m_buffers[1], m_buffers[0], m_numSamples* NBOFOUTPUTCHANNELS_OUT * CHANNELBYTES);
-                m_outputDevice->write(m_buffers[1],m_numSamples* NBOFOUTPUTCHANNELS_OUT * CHANNELBYTES);
-            }
-        }
-    }
+    m_buffer->push(data, samples, 0);
 }
 
 
-void AudioOutputWorkerThread::writeAudioBuffer(const short *buffer, int numSamples)
+
+AudioOutputBuffer::AudioOutputBuffer()
+    :   m_capacity(NBOFOUTPUTCHANNELS_OUT * SAMPLERATE_OUT * BUFFERSAMPLESIZEMSEC / 1000)
+    ,   m_readPos(0)
+    ,   m_fill(0)
+    ,   m_underrunBytes(0)
+    ,   m_silenceSamples(0)
+    ,   m_bytesDelivered(0)
+    ,   m_droppedSamples(0)
 {
-  tmutex.lock();
+    m_ring = new short[m_capacity];
+}
 
-  if (m_quit)
-  {
-      tmutex.unlock();
-      return;
-  }
+AudioOutputBuffer::~AudioOutputBuffer()
+{
+    delete [] m_ring;
+}
 
-  int p = 0;
-  int outSamples = 0;
+void AudioOutputBuffer::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_readPos = 0;
+    m_fill = 0;
+    m_silenceSamples = 0;
+    m_bytesDelivered = 0;
+}
 
-  if (numSamples > SAMPLERATE_IN * BUFFERSAMPLESIZEMSEC / 1000)
-  {
-    qWarning() << "input sample is bigger than the internal buffer!! nbsamples:" << numSamples << "   internal buffer:" << (SAMPLERATE_IN * BUFFERSAMPLESIZEMSEC / 1000);
-    numSamples = SAMPLERATE_IN * BUFFERSAMPLESIZEMSEC / 1000;
-  }
+void AudioOutputBuffer::discard()
+{
+    QMutexLocker lock(&m_mutex);
+    m_fill = 0;
+    m_silenceSamples = 0;
+}
+
+bool AudioOutputBuffer::open(OpenMode mode)
+{
+    QMutexLocker lock(&m_mutex);
+    return QIODevice::open(mode);
+}
+
+void AudioOutputBuffer::close()
+{
+    QMutexLocker lock(&m_mutex);
+    QIODevice::close();
+}
+
+qint64 AudioOutputBuffer::bytesDelivered() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_bytesDelivered;
+}
+
+int AudioOutputBuffer::bytesQueued() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_fill * CHANNELBYTES;
+}
+
+int AudioOutputBuffer::droppedSamples() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_droppedSamples;
+}
+
+void AudioOutputBuffer::push(const short *buffer, int numSamples, int concealedSamples)
+{
+    const int ratio = SAMPLERATE_OUT / SAMPLERATE_IN;
+
+    QMutexLocker lock(&m_mutex);
 
-  for (int i = 0 ; i < numSamples; i++)
-  {
-    short v = (short) buffer[i];
-    char l = v & 0xFF;
-    char h = (v & 0xFF00) >> 8;
+    if (!isOpen())
+        return;
 
-    // Destination buffer (Qt) recieves sound with 48000 Hz, so triple the sample...
-    for (int j = 0; j < SAMPLERATE_OUT/SAMPLERATE_IN ;j++)
+    // A concealed gap comes with the block after it, by which time the
+    // device may have run dry and played silence in its place. Playing the
+    // concealment as well would add that much latency for good, so as much
+    // of it is skipped as silence was played; the crossfade into the real
+    // samples stays.
+    int skip = qMin(concealedSamples, m_silenceSamples / ratio);
+    buffer += skip;
+    numSamples -= skip;
+    m_silenceSamples = 0;
+
+    int outSamples = numSamples * ratio;
+    if (outSamples > m_capacity)
+    {
+        qWarning() << "input sample is bigger than the internal buffer!! nbsamples:" << numSamples << "   internal buffer:" << (m_capacity / ratio);
+        buffer += numSamples - m_capacity / ratio;
+        numSamples = m_capacity / ratio;
+        outSamples = numSamples * ratio;
+    }
+
+    // When the device does not keep up, drop the oldest samples instead of
+    // the newest ones so the latency stays bounded.
+    int overflow = m_fill + outSamples - m_capacity;
+    if (overflow > 0)
+    {
+        m_readPos = (m_readPos + overflow) % m_capacity;
+        m_fill -= overflow;
+        m_droppedSamples += overflow;
+    }
+
+    int writePos = (m_readPos + m_fill) % m_capacity;
+    for (int i = 0 ; i < numSamples; i++)
+    {
+        // Destination buffer (Qt) recieves sound with 48000 Hz, so triple the sample...
+        for (int j = 0; j < ratio; j++)
+        {
+            m_ring[writePos++] = buffer[i];
+            if (writePos == m_capacity)
+                writePos = 0;
+        }
+    }
+    m_fill += outSamples;
+}
+
+qint64 AudioOutputBuffer::readData(char *data, qint64 maxlen)
+{
+    QMutexLocker lock(&m_mutex);
+
+    int samples = (int) qMin<qint64>(maxlen / CHANNELBYTES, m_fill);
+    if (samples == 0)
     {
-      m_buffers[0][p++] = l;
-      m_buffers[0][p++] = h;
-      outSamples++;
+        // Underrun: keep the device running with a chunk of silence
+        // rather than letting it fall into the idle state.
+        qint64 silence = qMin<qint64>(maxlen, m_underrunBytes) & ~(qint64)(CHANNELBYTES - 1);
+        memset(data, 0, silence);
+        m_bytesDelivered += silence;
+        m_silenceSamples = qMin(m_silenceSamples + (int)(silence / CHANNELBYTES), m_capacity);
+        return silence;
     }
-  }
 
-  m_numSamples = outSamples;
-  if (m_sem.available()>1)
-  {
-      //qWarning() << "buffer delays..";
-      return;
-  }
-  m_sem.release();
+    int first = qMin(samples, m_capacity - m_readPos);
+    memcpy(data, m_ring + m_readPos, first * CHANNELBYTES);
+    memcpy(data + first * CHANNELBYTES, m_ring, (samples - first) * CHANNELBYTES);
+    m_readPos = (m_readPos + samples) % m_capacity;
+    m_fill -= samples;
+
+    m_bytesDelivered += samples * CHANNELBYTES;
+    return samples * CHANNELBYTES;
+}
 
-  tmutex.unlock();
+qint64 AudioOutputBuffer::writeData(const char *data, qint64 len)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+    return 0;
 }
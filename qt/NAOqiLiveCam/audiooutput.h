@@ -8,12 +8,13 @@
 #include <QObject>
 #include <QIODevice>
 #include <QAudioOutput>
-#include <QThread>
-#include <QSemaphore>
+#include <QMutex>
+#include <QAtomicInt>
 
 #include "NAOqi/nao_interface/nao_interface.h"
+#include "audiospectrum.h"
 
-class AudioOutputWorkerThread;
+class AudioOutputBuffer;
 
 class AudioOutput : QObject, public NAOqiToPCAudioInterface
 {
@@ -25,7 +26,26 @@ public:
     void startPlay();
     void stopPlay();
 
-    virtual void writeData(const short *data, int samples);
+    virtual void writeData(const short *data, int samples, int concealedSamples);
+
+    // While muted the live stream is dropped and replayed audio is played
+    // through writeReplayData() instead.
+    void setLiveMuted(bool muted);
+    void writeReplayData(const short *data, int samples);
+
+    // Device buffer size in bytes, 0 for the backend default. Stops
+    // playback; the new size is used from the next startPlay().
+    void setBufferSize(int bytes);
+    // Length of the silence handed to the device on underrun. QAudioOutput
+    // has no setter for the device period, it follows the buffer size.
+    void setUnderrunChunkMsec(int msec);
+
+    // audio queued in the ring plus what the device has not played yet
+    qint64  outputLatencyUSecs() const;
+    int     bytesFree() const;
+    int     droppedSamples() const;
+
+    AudioSpectrum*  spectrum() { return &m_spectrum; }
 
 private:
     void initializeAudio();
@@ -34,34 +54,61 @@ private:
 private:
     QAudioDeviceInfo        m_device;
     QAudioOutput*           m_audioOutput;
-    QIODevice*              m_outputDevice; // not owned
     QAudioFormat            m_format;
-    AudioOutputWorkerThread *m_workderThread;
+    AudioOutputBuffer       *m_buffer;
+    int                     m_bufferSize;
+    qint64                  m_deviceLatencyUSecs;
+    AudioSpectrum           m_spectrum;
+    QAtomicInt              m_liveMuted;
 
 private slots:
     void stateChanged(QAudio::State state);
     void deviceChanged(int index);
+    void notified();
 };
 
 
-class AudioOutputWorkerThread : public QThread
+// Pull mode source for QAudioOutput. NAOqi's audio callback pushes PCM into
+// a ring buffer and the audio device drains it directly from readData(), so
+// no extra thread sits in the audio path.
+class AudioOutputBuffer : public QIODevice
 {
     Q_OBJECT
 
 public:
-    AudioOutputWorkerThread();
-    virtual ~AudioOutputWorkerThread();
+    AudioOutputBuffer();
+    virtual ~AudioOutputBuffer();
+
+    // concealedSamples at the start of buffer stand in for a gap the
+    // device may already have played as silence
+    void    push(const short *buffer, int numSamples, int concealedSamples);
+    void    clear();
+    void    discard();      // drops queued samples, keeps the counters
+    void    setUnderrunBytes(int bytes) { m_underrunBytes = bytes; }
+
+    // push() runs on the NAOqi thread, so opening and closing take the
+    // same lock
+    virtual bool open(OpenMode mode);
+    virtual void close();
+
+    qint64  bytesDelivered() const;
+    int     bytesQueued() const;
+    int     droppedSamples() const;
 
-    void    run();
-    void    setOutputDevice(QIODevice *output) { m_outputDevice = output; }
-    void    writeAudioBuffer(const signed short *buffer, int numSamples);
+protected:
+    qint64  readData(char *data, qint64 maxlen);
+    qint64  writeData(const char *data, qint64 len);
 
 private:
-    bool                        m_quit;
-    char                        *m_buffers[2];
-    int                         m_numSamples;
-    QIODevice                   *m_outputDevice;
-    QSemaphore                  m_sem;
+    mutable QMutex              m_mutex;
+    short                       *m_ring;
+    int                         m_capacity;     // samples
+    int                         m_readPos;
+    int                         m_fill;
+    int                         m_underrunBytes;
+    int                         m_silenceSamples;   // underrun silence played since the last push
+    qint64                      m_bytesDelivered;
+    int                         m_droppedSamples;
 };
 #endif
 
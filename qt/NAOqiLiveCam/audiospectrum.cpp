@@ -0,0 +1,79 @@
+/**
+ * Level and spectrum tap on the incoming audio stream
+ * Created 2026/10/19
+ */
+
+#include <math.h>
+#include <string.h>
+#include "audiospectrum.h"
+
+static const float MIN_DB = -90.0f;
+
+static float toDb(float value)
+{
+    return value > 0.0f ? qMax(MIN_DB, 20.0f * log10f(value)) : MIN_DB;
+}
+
+AudioSpectrum::AudioSpectrum()
+    :   m_written(0)
+    ,   m_lastAnalyzed(0)
+    ,   m_fft(FFT_SIZE)
+    ,   m_samples(FFT_SIZE)
+    ,   m_magnitudes(FFT_SIZE / 2)
+{
+    memset(m_ring, 0, sizeof(m_ring));
+}
+
+void AudioSpectrum::write(const short *data, int samples)
+{
+    // single producer: only this thread modifies m_written
+    unsigned int pos = (unsigned int) m_written.fetchAndAddAcquire(0);
+    for (int i = 0; i < samples; i++)
+        m_ring[(pos + i) & (RING_SIZE - 1)] = data[i];
+    m_written.fetchAndStoreRelease((int)(pos + samples));
+}
+
+bool AudioSpectrum::analyze(float *bands, int numBands, float *rmsDb, float *peakDb)
+{
+    int written = m_written.fetchAndAddAcquire(0);
+    if (written == m_lastAnalyzed)
+        return false;
+    m_lastAnalyzed = written;
+
+    unsigned int start = (unsigned int) written - FFT_SIZE;
+    float *samples = m_samples.data();
+    for (int i = 0; i < FFT_SIZE; i++)
+        samples[i] = m_ring[(start + i) & (RING_SIZE - 1)] / 32768.0f;
+
+    // The writer may have lapped us while copying; the block is then torn
+    // and simply skipped until the next display refresh.
+    unsigned int after = (unsigned int) m_written.fetchAndAddAcquire(0);
+    if (after - start > (unsigned int)(RING_SIZE - FFT_SIZE))
+        return false;
+
+    float sum = 0.0f;
+    float peak = 0.0f;
+    for (int i = 0; i < FFT_SIZE; i++)
+    {
+        sum += samples[i] * samples[i];
+        peak = qMax(peak, fabsf(samples[i]));
+    }
+    *rmsDb = toDb(sqrtf(sum / FFT_SIZE));
+    *peakDb = toDb(peak);
+
+    m_fft.magnitudes(samples, m_magnitudes.data());
+
+    // logarithmically spaced bands of at least one bin, skipping DC
+    const int bins = FFT_SIZE / 2;
+    int first = 1;
+    for (int b = 0; b < numBands; b++)
+    {
+        int last = qMax(first + 1, (int) powf((float) bins, (float)(b + 1) / numBands));
+        float value = 0.0f;
+        for (int k = first; k < last && k < bins; k++)
+            value = qMax(value, m_magnitudes[k]);
+        bands[b] = toDb(value);
+        first = last;
+    }
+    return true;
+}
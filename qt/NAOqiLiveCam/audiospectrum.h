@@ -0,0 +1,39 @@
+/**
+ * Level and spectrum tap on the incoming audio stream
+ * Created 2026/10/19
+ */
+#ifndef AUDIOSPECTRUM_H
+#define AUDIOSPECTRUM_H
+
+#include <QAtomicInt>
+#include <QVector>
+
+#include "realfft.h"
+
+// Level and spectrum analysis tap on the incoming PCM stream. write() is
+// called from the NAOqi audio callback and only copies into a lock free
+// single producer ring; analyze() runs on the GUI thread at display rate
+// on the newest FFT_SIZE samples.
+class AudioSpectrum
+{
+public:
+    enum { FFT_SIZE = 512, RING_SIZE = 8192 };
+
+    AudioSpectrum();
+
+    void    write(const short *data, int samples);
+
+    // Returns false when no new samples arrived since the last call.
+    bool    analyze(float *bands, int numBands, float *rmsDb, float *peakDb);
+
+private:
+    short               m_ring[RING_SIZE];
+    QAtomicInt          m_written;      // total samples written, wraps
+    int                 m_lastAnalyzed;
+
+    RealFFT             m_fft;
+    QVector<float>      m_samples;
+    QVector<float>      m_magnitudes;
+};
+
+#endif
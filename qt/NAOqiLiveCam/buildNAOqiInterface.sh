@@ -5,5 +5,6 @@ cd NAOqi
 #qibuild install nao_interface ../../build
 qibuild configure --release nao_interface
 qibuild install --release nao_interface ../../build
+#qibuild test --release nao_interface
 
 cd ..
@@ -9,13 +9,27 @@
 
 #include <QMutex>
 #include <QQueue>
+#include <QDir>
+#include <QMouseEvent>
+#include <QRubberBand>
+#include <QPainter>
+#include <QFileInfo>
+#include <QCoreApplication>
+#include <math.h>
 
 #include "audiooutput.h"
+#include "snapshotcapture.h"
+#include "pixelconversion.h"
 
 static bool s_isConnected = false;
 static QMutex s_consoleMutex;
 static QQueue<QString> s_pendingConsoleMessages;
 static MainWindow *s_window = NULL;
+static QRectF s_regionOfInterest(0, 0, 1, 1);
+
+// field of view of the NAO cameras
+static const float CAMERA_HFOV = 60.97f * M_PI / 180.0f;
+static const float CAMERA_VFOV = 47.64f * M_PI / 180.0f;
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -24,32 +38,106 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->setupUi(this);
     ui->disconnectButton->setEnabled(false);
     ui->connectButton->setEnabled(true);
+    ui->snapshotButton->setEnabled(false);
     ui->console->setMaximumBlockCount(100);
     ui->console->setReadOnly(true);
     QFont monofont("Courier");
     monofont.setStyleHint(QFont::Monospace);
     ui->console->setFont(monofont);
 
+    // drag a rectangle on the camera view to zoom in, double click to reset,
+    // drag with the right button to turn the head
+    d_roiBand = new QRubberBand(QRubberBand::Rectangle, ui->cameraView);
+    ui->cameraView->installEventFilter(this);
+    d_headDragging = false;
+    d_headStartYaw = 0;
+    d_headStartPitch = 0;
+    if (QCoreApplication::arguments().contains("--simulate-head"))
+        NaoInterface::instance()->setHeadSimulation(true);
+    d_lastStreamStats.frames = 0;
+    d_lastStreamStats.wireBytes = 0;
+    d_lastStreamStats.displayBytes = 0;
+    d_lastFps = 0;
+    d_lastWireKBytes = 0;
+    d_zoomBaseFps = 0;
+    d_zoomBaseWireKBytes = 0;
+    d_lastAnalysisStats.analyzed = 0;
+    d_lastAnalysisStats.dropped = 0;
+    d_lastAnalysisStats.lastUSecs = 0;
+
+    // the replay ring is allocated once here, live capture only reuses it
+    NaoInterface::instance()->setReplayBuffer(REPLAY_SECONDS, REPLAY_MAX_BYTES);
+    d_replayPlaying = false;
+    d_replayCursor = 0;
+    d_replayPlayStart = 0;
+    d_replayLast = 0;
+    d_replayAudio.resize(SAMPLERATE_IN);
+
     connect(this, SIGNAL(consoleUpdated()), this, SLOT(update()), Qt::AutoConnection);
     connect(ui->connectButton, SIGNAL(clicked()), this, SLOT(connectButtonClicked()));
     connect(ui->disconnectButton, SIGNAL(clicked()), this, SLOT(disconnectButtonClicked()));
+    connect(ui->snapshotButton, SIGNAL(clicked()), this, SLOT(snapshotButtonClicked()));
+    connect(ui->colorSpace, SIGNAL(currentIndexChanged(int)), this, SLOT(colorSpaceChanged(int)));
+    connect(ui->resolution, SIGNAL(currentIndexChanged(int)), this, SLOT(resolutionChanged(int)));
+    connect(ui->adaptiveQuality, SIGNAL(toggled(bool)), this, SLOT(adaptiveQualityToggled(bool)));
+    connect(ui->denoiseFilter, SIGNAL(toggled(bool)), this, SLOT(filterToggled()));
+    connect(ui->whiteBalanceFilter, SIGNAL(toggled(bool)), this, SLOT(filterToggled()));
+    connect(ui->gammaFilter, SIGNAL(toggled(bool)), this, SLOT(filterToggled()));
+    connect(ui->sharpenFilter, SIGNAL(toggled(bool)), this, SLOT(filterToggled()));
+    connect(ui->analysis, SIGNAL(toggled(bool)), this, SLOT(analysisToggled(bool)));
+    connect(ui->audioBuffer, SIGNAL(valueChanged(int)), this, SLOT(audioBufferChanged(int)));
+    connect(ui->replayPauseButton, SIGNAL(toggled(bool)), this, SLOT(replayPauseToggled(bool)));
+    connect(ui->replayPlayButton, SIGNAL(clicked()), this, SLOT(replayPlayClicked()));
+    connect(ui->replaySlider, SIGNAL(valueChanged(int)), this, SLOT(replaySliderChanged(int)));
 
     d_cameraIntervalTimer = new QTimer(this);
     d_cameraIntervalTimer->setInterval(1000/CAMERA_FPS);
     connect(d_cameraIntervalTimer, SIGNAL(timeout()), this, SLOT(updateCameraView()));
 
+    d_statusTimer = new QTimer(this);
+    d_statusTimer->setInterval(1000);
+    connect(d_statusTimer, SIGNAL(timeout()), this, SLOT(updateStatus()));
+    d_statusTimer->start();
+
+    d_replayTimer = new QTimer(this);
+    d_replayTimer->setInterval(1000 / 30);
+    connect(d_replayTimer, SIGNAL(timeout()), this, SLOT(updateReplay()));
+
+    // a short hide only stops polling, the subscription goes after a while
+    d_demandTimer = new QTimer(this);
+    d_demandTimer->setInterval(3000);
+    d_demandTimer->setSingleShot(true);
+    connect(d_demandTimer, SIGNAL(timeout()), this, SLOT(updateFrameDemand()));
+
     s_window = this;
 
     d_audio = new AudioOutput();
+    ui->spectrumView->setSource(d_audio->spectrum());
+
+    d_snapshot = new SnapshotCapture();
+    d_snapshot->start();
 }
 
 MainWindow::~MainWindow()
 {
+    if (d_snapshot)
+        delete d_snapshot;
+
     NaoInterface::instance()->disconnect();
 
     if (d_cameraIntervalTimer)
         d_cameraIntervalTimer->stop();
 
+    if (d_statusTimer)
+        d_statusTimer->stop();
+
+    if (d_replayTimer)
+        d_replayTimer->stop();
+
+    if (d_demandTimer)
+        d_demandTimer->stop();
+
+    ui->spectrumView->setSource(0);
     if (d_audio)
         delete d_audio;
 
@@ -66,7 +154,7 @@ void MainWindow::consoleMessage(const QString &msg)
     s_pendingConsoleMessages.append(msg);
     if (s_window)
     {
-        if (hasPendingMessage)
+        if (!hasPendingMessage)
         {
             emit s_window->consoleUpdated();
         }
@@ -87,10 +175,11 @@ void MainWindow::connectButtonClicked()
         ui->console->appendPlainText("connected!");
         ui->connectButton->setEnabled(false);
         ui->disconnectButton->setEnabled(true);
+        ui->snapshotButton->setEnabled(true);
         ui->naoIp->setReadOnly(true);
         s_isConnected = true;
 
-        d_cameraIntervalTimer->start();
+        applyCaptureInterval();
         d_audio->startPlay();
     }
     catch ( std::string exceptionMsg )
@@ -115,6 +204,7 @@ void MainWindow::disconnectButtonClicked()
         ui->console->appendPlainText("disconnected!");
         ui->connectButton->setEnabled(true);
         ui->disconnectButton->setEnabled(false);
+        ui->snapshotButton->setEnabled(false);
         ui->naoIp->setReadOnly(false);
         s_isConnected = false;
     }
@@ -126,6 +216,20 @@ void MainWindow::disconnectButtonClicked()
     }
 }
 
+void MainWindow::snapshotButtonClicked()
+{
+    int resolution = ui->snapshotResolution->currentIndex() == 0 ? NAO_RES_VGA : NAO_RES_4VGA;
+    if (!d_snapshot->requestCapture(resolution, ui->snapshotBurst->value(), QDir::homePath()))
+    {
+        ui->console->appendPlainText("snapshot: previous capture is still running.");
+        return;
+    }
+    QString msg = "snapshot: capturing to ";
+    msg.append(QDir::homePath());
+    msg.append("...");
+    ui->console->appendPlainText(msg);
+}
+
 void MainWindow::paintEvent(QPaintEvent *event)
 {
     QMutexLocker lock(&s_consoleMutex);
@@ -137,8 +241,511 @@ void MainWindow::paintEvent(QPaintEvent *event)
     QMainWindow::paintEvent(event);
 }
 
+// The user's choice, the top of the adaptive quality ladder. The combo
+// indexes follow NaoCameraResolution and NaoColorSpace.
+static QualityController::Setting baseQualitySetting(Ui::MainWindow *ui)
+{
+    QualityController::Setting setting;
+    setting.resolution = ui->resolution->currentIndex();
+    setting.colorSpace = ui->colorSpace->currentIndex();
+    setting.fps = CAMERA_FPS;
+    return setting;
+}
+
+void MainWindow::colorSpaceChanged(int index)
+{
+    (void)index;
+    d_quality.reset(baseQualitySetting(ui));
+    applyQualitySetting();
+}
+
+void MainWindow::resolutionChanged(int index)
+{
+    (void)index;
+    d_quality.reset(baseQualitySetting(ui));
+    applyQualitySetting();
+}
+
+void MainWindow::adaptiveQualityToggled(bool enabled)
+{
+    d_quality.reset(baseQualitySetting(ui));
+    d_quality.setEnabled(enabled);
+    applyQualitySetting();
+}
+
+static QCheckBox* filterCheckBox(Ui::MainWindow *ui, int filter)
+{
+    switch (filter)
+    {
+    case NAO_FILTER_DENOISE:        return ui->denoiseFilter;
+    case NAO_FILTER_WHITE_BALANCE:  return ui->whiteBalanceFilter;
+    case NAO_FILTER_GAMMA:          return ui->gammaFilter;
+    default:                        return ui->sharpenFilter;
+    }
+}
+
+void MainWindow::filterToggled()
+{
+    for (int i = 0; i < NAO_FILTER_COUNT; i++)
+    {
+        NaoInterface::instance()->setFilterEnabled(i, filterCheckBox(ui, i)->isChecked());
+    }
+}
+
+void MainWindow::analysisToggled(bool enabled)
+{
+    // the face cascade is optional, without it only people are detected
+    QString cascade = QCoreApplication::applicationDirPath() + "/haarcascade_frontalface_alt.xml";
+    if (!QFileInfo(cascade).exists())
+        cascade = "";
+    NaoInterface::instance()->setAnalysisEnabled(enabled, cascade.toStdString());
+    updateFrameDemand();
+}
+
+// The device buffer is only applied when playback starts, so a running
+// stream is restarted with the new size.
+void MainWindow::audioBufferChanged(int msec)
+{
+    d_audio->setBufferSize(SAMPLERATE_OUT * NBOFOUTPUTCHANNELS_OUT * CHANNELBYTES * msec / 1000);
+    if (s_isConnected)
+        d_audio->startPlay();
+}
+
+void MainWindow::applyQualitySetting()
+{
+    QualityController::Setting setting = d_quality.currentSetting();
+    NaoInterface *nao = NaoInterface::instance();
+    nao->setCameraResolution(setting.resolution);
+    nao->setCameraColorSpace(setting.colorSpace);
+    nao->setCameraFrameRate(setting.fps);
+    applyCaptureInterval();
+}
+
+// Polls at the rate the subscription currently runs at, not at all while
+// the camera is paused for lack of demand.
+void MainWindow::applyCaptureInterval()
+{
+    int fps = NaoInterface::instance()->subscribedFrameRate();
+    if (!s_isConnected || fps <= 0)
+    {
+        d_cameraIntervalTimer->stop();
+        return;
+    }
+    d_cameraIntervalTimer->setInterval(1000 / fps);
+    if (!d_cameraIntervalTimer->isActive())
+        d_cameraIntervalTimer->start();
+}
+
+bool MainWindow::isViewVisible() const
+{
+    return isVisible() && !isMinimized();
+}
+
+void MainWindow::updateFrameDemand()
+{
+    d_demandTimer->stop();
+
+    bool visible = isViewVisible();
+    bool replaying = ui->replayPauseButton->isChecked();
+    NaoInterface *nao = NaoInterface::instance();
+    nao->setFrameDemand(NAO_CONSUMER_VIEW, visible && !replaying ? NAO_DEMAND_FULL : NAO_DEMAND_NONE);
+    // keep the replay ring filling while the user scrubs through it
+    nao->setFrameDemand(NAO_CONSUMER_RECORDER, visible && replaying ? NAO_DEMAND_FULL : NAO_DEMAND_NONE);
+    nao->setFrameDemand(NAO_CONSUMER_ANALYSIS, ui->analysis->isChecked() ? NAO_DEMAND_LOW : NAO_DEMAND_NONE);
+    applyCaptureInterval();
+}
+
+void MainWindow::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::WindowStateChange)
+    {
+        if (isViewVisible())
+        {
+            updateFrameDemand();
+        }
+        else
+        {
+            d_cameraIntervalTimer->stop();
+            d_demandTimer->start();
+        }
+    }
+    QMainWindow::changeEvent(event);
+}
+
+void MainWindow::showEvent(QShowEvent *event)
+{
+    updateFrameDemand();
+    QMainWindow::showEvent(event);
+}
+
+void MainWindow::hideEvent(QHideEvent *event)
+{
+    d_cameraIntervalTimer->stop();
+    d_demandTimer->start();
+    QMainWindow::hideEvent(event);
+}
+
 void MainWindow::updateCameraView()
 {
-    QImage img(NaoInterface::instance()->updateCameraView(),320,240,QImage::Format_RGB888);
-    ui->cameraView->setPixmap(QPixmap::fromImage(img));
+    NaoInterface *nao = NaoInterface::instance();
+    const unsigned char *data = nao->updateCameraView();
+    if (data == NULL)
+        return;
+
+    NaoStreamStats stats;
+    nao->getStreamStats(stats);
+    // frames pulled at a reduced demand say nothing about the link quality
+    if (nao->frameDemand() == NAO_DEMAND_FULL && d_quality.addFrame(stats.lastRoundTripUSecs, stats.lastFrameBytes))
+    {
+        applyQualitySetting();
+        ui->console->appendPlainText(d_quality.lastDecision());
+    }
+
+    // while replaying, live frames only go into the replay ring
+    if (ui->replayPauseButton->isChecked() || !isViewVisible())
+        return;
+
+    if (!convertCameraFrame(data, nao->cameraWidth(), nao->cameraHeight(), nao->cameraColorSpace(), d_cameraImage))
+        return;
+    showCameraImage(ui->analysis->isChecked());
+}
+
+void MainWindow::showCameraImage(bool withDetections)
+{
+    QPixmap pixmap = QPixmap::fromImage(d_cameraImage);
+    if (pixmap.size() != ui->cameraView->size())
+        pixmap = pixmap.scaled(ui->cameraView->size(), Qt::KeepAspectRatio, Qt::FastTransformation);
+    if (withDetections)
+        drawDetections(pixmap);
+    ui->cameraView->setPixmap(pixmap);
+}
+
+void MainWindow::replayPauseToggled(bool paused)
+{
+    d_replayPlaying = false;
+    d_audio->setLiveMuted(paused);
+    updateFrameDemand();
+    if (paused)
+    {
+        NaoReplayInfo info;
+        NaoInterface::instance()->getReplayInfo(info);
+        d_replayCursor = info.lastTimestamp;
+        d_replayTimer->start();
+        updateReplay();
+    }
+    else
+    {
+        d_replayTimer->stop();
+    }
+    ui->replayPauseButton->setText(paused ? "Live" : "Pause");
+    ui->replayPlayButton->setText("Play");
+    ui->replayPlayButton->setEnabled(paused);
+    ui->replaySlider->setEnabled(paused);
+}
+
+void MainWindow::replayPlayClicked()
+{
+    d_replayPlaying = !d_replayPlaying;
+    d_replayPlayStart = d_replayCursor;
+    d_replayClock.start();
+    ui->replayPlayButton->setText(d_replayPlaying ? "Stop" : "Play");
+}
+
+void MainWindow::replaySliderChanged(int value)
+{
+    // slider positions are msec relative to the newest frame in the ring
+    d_replayCursor = d_replayLast + (long long) value * 1000;
+    d_replayPlayStart = d_replayCursor;
+    d_replayClock.restart();
+    updateReplay();
+}
+
+void MainWindow::updateReplay()
+{
+    NaoInterface *nao = NaoInterface::instance();
+    NaoReplayInfo info;
+    nao->getReplayInfo(info);
+    if (info.frames == 0)
+        return;
+
+    if (d_replayPlaying)
+    {
+        long long next = d_replayPlayStart + d_replayClock.elapsed() * 1000;
+        long long from = qMax(d_replayCursor, next - 1000000);
+        int samples = nao->getReplayAudio(from, next, d_replayAudio.data(), d_replayAudio.size());
+        d_audio->writeReplayData(d_replayAudio.constData(), samples);
+        d_replayCursor = next;
+        if (d_replayCursor >= info.lastTimestamp)
+        {
+            // caught up with live capture
+            ui->replayPauseButton->setChecked(false);
+            return;
+        }
+    }
+    if (d_replayCursor < info.firstTimestamp)
+    {
+        // the frames under the cursor were overwritten, go on from the oldest
+        d_replayCursor = info.firstTimestamp;
+        d_replayPlayStart = d_replayCursor;
+        d_replayClock.restart();
+    }
+    d_replayCursor = qMin(d_replayCursor, info.lastTimestamp);
+    d_replayLast = info.lastTimestamp;
+
+    ui->replaySlider->blockSignals(true);
+    ui->replaySlider->setRange((int)((info.firstTimestamp - info.lastTimestamp) / 1000), 0);
+    ui->replaySlider->setValue((int)((d_replayCursor - info.lastTimestamp) / 1000));
+    ui->replaySlider->blockSignals(false);
+
+    // grows up to the largest frame format in use, then stays
+    if (d_replayFrame.size() < info.maxFrameBytes)
+        d_replayFrame.resize(info.maxFrameBytes);
+
+    int width, height, colorSpace;
+    long long timestamp;
+    if (!nao->getReplayFrame(d_replayCursor, d_replayFrame.data(), d_replayFrame.size(), &width, &height, &colorSpace, &timestamp))
+        return;
+    if (!convertCameraFrame(d_replayFrame.constData(), width, height, colorSpace, d_cameraImage))
+        return;
+    showCameraImage(false);
+}
+
+// Draws the latest analysis results. They come from an earlier frame, so
+// they are only shown while they are less than a second older than the
+// frame on screen.
+void MainWindow::drawDetections(QPixmap &pixmap)
+{
+    const int maxDetections = 32;
+    NaoDetection detections[maxDetections];
+    long long timestamp = 0;
+    int count = NaoInterface::instance()->getDetections(detections, maxDetections, &timestamp);
+    long long age = NaoInterface::instance()->cameraTimestamp() - timestamp;
+    if (count == 0 || age < 0 || age > 1000000)
+        return;
+
+    QPainter painter(&pixmap);
+    for (int i = 0; i < count; i++)
+    {
+        painter.setPen(QPen(detections[i].kind == NAO_DETECT_FACE ? Qt::green : Qt::yellow, 2));
+        painter.drawRect(QRectF(detections[i].x * pixmap.width(), detections[i].y * pixmap.height(),
+                                detections[i].width * pixmap.width(), detections[i].height * pixmap.height()));
+    }
+}
+
+// Area of the camera view covered by the current frame (the pixmap is
+// scaled keeping the aspect ratio and centered)
+QRect MainWindow::displayedImageRect() const
+{
+    if (d_cameraImage.isNull())
+        return ui->cameraView->rect();
+
+    QSize size = d_cameraImage.size();
+    size.scale(ui->cameraView->size(), Qt::KeepAspectRatio);
+    QRect rect(QPoint(0, 0), size);
+    rect.moveCenter(ui->cameraView->rect().center());
+    return rect;
+}
+
+void MainWindow::selectRegionOfInterest(const QRect &selection)
+{
+    QRect image = displayedImageRect();
+    QRect rect = selection.intersected(image);
+    if (rect.width() < 8 || rect.height() < 8)
+        return;
+
+    float x = (float)(rect.x() - image.x()) / image.width();
+    float y = (float)(rect.y() - image.y()) / image.height();
+    float w = (float)rect.width() / image.width();
+    float h = (float)rect.height() / image.height();
+
+    // a selection made while zoomed refines the current region
+    NaoInterface *nao = NaoInterface::instance();
+    if (!nao->hasRegionOfInterest())
+    {
+        s_regionOfInterest = QRectF(0, 0, 1, 1);
+        d_zoomBaseFps = d_lastFps;
+        d_zoomBaseWireKBytes = d_lastWireKBytes;
+    }
+    s_regionOfInterest = QRectF(s_regionOfInterest.x() + x * s_regionOfInterest.width(),
+                                s_regionOfInterest.y() + y * s_regionOfInterest.height(),
+                                w * s_regionOfInterest.width(),
+                                h * s_regionOfInterest.height());
+    nao->setRegionOfInterest(s_regionOfInterest.x(), s_regionOfInterest.y(),
+                             s_regionOfInterest.width(), s_regionOfInterest.height(),
+                             ui->cameraView->width());
+}
+
+// The scene follows the pointer: dragging by a full view width turns the
+// head by the (zoomed) field of view.
+void MainWindow::dragHead(const QPoint &pos)
+{
+    QRect image = displayedImageRect();
+    float zoom = NaoInterface::instance()->hasRegionOfInterest() ? s_regionOfInterest.width() : 1.0f;
+    float yaw = d_headStartYaw + (float)(pos.x() - d_headOrigin.x()) / image.width() * CAMERA_HFOV * zoom;
+    float pitch = d_headStartPitch - (float)(pos.y() - d_headOrigin.y()) / image.height() * CAMERA_VFOV * zoom;
+    NaoInterface::instance()->setHeadTarget(yaw, pitch);
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched != ui->cameraView)
+        return QMainWindow::eventFilter(watched, event);
+
+    QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
+    switch (event->type())
+    {
+    case QEvent::MouseButtonPress:
+        if (mouseEvent->button() == Qt::LeftButton)
+        {
+            d_roiOrigin = mouseEvent->pos();
+            d_roiBand->setGeometry(QRect(d_roiOrigin, QSize()));
+            d_roiBand->show();
+            return true;
+        }
+        if (mouseEvent->button() == Qt::RightButton &&
+            NaoInterface::instance()->getHeadTarget(&d_headStartYaw, &d_headStartPitch))
+        {
+            d_headOrigin = mouseEvent->pos();
+            d_headDragging = true;
+            return true;
+        }
+        break;
+    case QEvent::MouseMove:
+        if (d_roiBand->isVisible())
+        {
+            d_roiBand->setGeometry(QRect(d_roiOrigin, mouseEvent->pos()).normalized());
+            return true;
+        }
+        if (d_headDragging)
+        {
+            dragHead(mouseEvent->pos());
+            return true;
+        }
+        break;
+    case QEvent::MouseButtonRelease:
+        if (mouseEvent->button() == Qt::LeftButton && d_roiBand->isVisible())
+        {
+            d_roiBand->hide();
+            selectRegionOfInterest(QRect(d_roiOrigin, mouseEvent->pos()).normalized());
+            return true;
+        }
+        if (mouseEvent->button() == Qt::RightButton && d_headDragging)
+        {
+            d_headDragging = false;
+            return true;
+        }
+        break;
+    case QEvent::MouseButtonDblClick:
+        NaoInterface::instance()->clearRegionOfInterest();
+        return true;
+    default:
+        break;
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+static QString headStatus()
+{
+    NaoHeadStats stats;
+    NaoInterface::instance()->getHeadStats(stats);
+    if (stats.requested == 0)
+        return QString();
+    return QString("head %1 cmds  %2 coalesced  %3 failed  latency %4 ms  |  ")
+            .arg(stats.sent)
+            .arg(stats.coalesced)
+            .arg(stats.failed)
+            .arg(stats.averageLatencyUSecs / 1000);
+}
+
+void MainWindow::updateStatus()
+{
+    if (!s_isConnected)
+    {
+        // the simulated head can be driven without a robot
+        QString status = headStatus();
+        if (status.isEmpty())
+            ui->statusBar->clearMessage();
+        else
+            ui->statusBar->showMessage(status);
+        return;
+    }
+
+    NaoStreamStats stats;
+    NaoInterface::instance()->getStreamStats(stats);
+    int fps = stats.frames - d_lastStreamStats.frames;
+    int wireKBytes = (stats.wireBytes - d_lastStreamStats.wireBytes) / 1024;
+    QString status = QString("%1 fps  wire %2 kB/s  shown %3 kB/s  |  ")
+            .arg(fps)
+            .arg(wireKBytes)
+            .arg((stats.displayBytes - d_lastStreamStats.displayBytes) / 1024);
+    d_lastStreamStats = stats;
+
+    // the robot sends whole frames whatever the zoom; show the wire rate and
+    // fps against the last unzoomed second so any change is visible
+    if (NaoInterface::instance()->hasRegionOfInterest() && d_zoomBaseFps > 0 && d_zoomBaseWireKBytes > 0)
+    {
+        status += QString("zoom: wire %1%  fps %2% of unzoomed  |  ")
+                .arg(wireKBytes * 100 / d_zoomBaseWireKBytes)
+                .arg(fps * 100 / d_zoomBaseFps);
+    }
+    else
+    {
+        d_lastFps = fps;
+        d_lastWireKBytes = wireKBytes;
+    }
+
+    status += QString("rtt %1 ms  link %2 kB/s  quality %3  |  ")
+            .arg(d_quality.averageRoundTripMSecs())
+            .arg(d_quality.throughputKBytes())
+            .arg(d_quality.isEnabled() ? QString::number(d_quality.level()) : QString("fixed"));
+
+    if (ui->analysis->isChecked())
+    {
+        NaoAnalysisStats analysisStats;
+        NaoInterface::instance()->getAnalysisStats(analysisStats);
+        status += QString("analysis %1 fps (%2 ms) dropped %3  |  ")
+                .arg(analysisStats.analyzed - d_lastAnalysisStats.analyzed)
+                .arg(analysisStats.lastUSecs / 1000)
+                .arg(analysisStats.dropped - d_lastAnalysisStats.dropped);
+        d_lastAnalysisStats = analysisStats;
+    }
+
+    NaoReplayInfo replayInfo;
+    NaoInterface::instance()->getReplayInfo(replayInfo);
+    status += QString("replay %1 s in %2 / %3 MB  |  ")
+            .arg((replayInfo.lastTimestamp - replayInfo.firstTimestamp) / 1000000)
+            .arg(replayInfo.bytesUsed / (1024 * 1024))
+            .arg(replayInfo.bytesCapacity / (1024 * 1024));
+
+    status += headStatus();
+
+    NaoDemandStats demandStats;
+    NaoInterface::instance()->getDemandStats(demandStats);
+    status += QString("idle %1 s  saved %2 MB / %3 frames / %4 s cpu  |  ")
+            .arg((demandStats.pausedUSecs + demandStats.throttledUSecs) / 1000000)
+            .arg(demandStats.savedBytes / (1024 * 1024))
+            .arg(demandStats.savedFrames)
+            .arg(demandStats.savedCpuUSecs / 1000000.0, 0, 'f', 1);
+
+    NaoAudioStats audioStats;
+    NaoInterface::instance()->getAudioStats(audioStats);
+    status += QString("audio latency %1 ms  free %2 bytes  dropped %3  gaps %4 (%5 ms concealed, %6 outages)")
+            .arg(d_audio->outputLatencyUSecs() / 1000)
+            .arg(d_audio->bytesFree())
+            .arg(d_audio->droppedSamples())
+            .arg(audioStats.gaps)
+            .arg(audioStats.concealedUSecs / 1000)
+            .arg(audioStats.outages);
+    ui->statusBar->showMessage(status);
+
+    // per stage cost of the post processing chain
+    for (int i = 0; i < NAO_FILTER_COUNT; i++)
+    {
+        NaoFilterStats filterStats;
+        NaoInterface::instance()->getFilterStats(i, filterStats);
+        QCheckBox *checkBox = filterCheckBox(ui, i);
+        checkBox->setToolTip(filterStats.enabled ?
+                    QString("%1 us/frame, %2 frames, %3 skipped").arg(filterStats.averageUSecs).arg(filterStats.runs).arg(filterStats.skipped) :
+                    QString());
+    }
 }
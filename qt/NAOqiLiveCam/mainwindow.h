@@ -8,18 +8,30 @@
 
 #include <QMainWindow>
 #include <QTimer>
+#include <QImage>
+#include <QPoint>
+#include <QVector>
+#include <QElapsedTimer>
+
+#include "NAOqi/nao_interface/nao_interface.h"
+#include "qualitycontroller.h"
 
 namespace Ui {
 class MainWindow;
 }
 
 class AudioOutput;
+class SnapshotCapture;
+class QRubberBand;
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
     QTimer          *d_cameraIntervalTimer;
+    QTimer          *d_statusTimer;
+    QTimer          *d_replayTimer;
+    QTimer          *d_demandTimer;
 
 public:
     explicit MainWindow(QWidget *parent = 0);
@@ -30,14 +42,66 @@ public:
 private:
     Ui::MainWindow  *ui;
     AudioOutput     *d_audio;
+    SnapshotCapture *d_snapshot;
+    QImage          d_cameraImage;
+    QRubberBand     *d_roiBand;
+    QPoint          d_roiOrigin;
+    bool            d_headDragging;
+    QPoint          d_headOrigin;
+    float           d_headStartYaw;
+    float           d_headStartPitch;
+    NaoStreamStats  d_lastStreamStats;
+    // rates of the last status tick, and those from before zooming in
+    int             d_lastFps;
+    int             d_lastWireKBytes;
+    int             d_zoomBaseFps;
+    int             d_zoomBaseWireKBytes;
+    NaoAnalysisStats d_lastAnalysisStats;
+    QualityController d_quality;
+
+    // instant replay, d_replayCursor is the NAOqi time stamp on screen
+    bool            d_replayPlaying;
+    long long       d_replayCursor;
+    long long       d_replayPlayStart;
+    long long       d_replayLast;
+    QElapsedTimer   d_replayClock;
+    QVector<unsigned char> d_replayFrame;
+    QVector<short>  d_replayAudio;
+
+    void    applyQualitySetting();
+    void    applyCaptureInterval();
+    bool    isViewVisible() const;
+    void    drawDetections(QPixmap &pixmap);
+    void    showCameraImage(bool withDetections);
+
+    QRect   displayedImageRect() const;
+    void    selectRegionOfInterest(const QRect &selection);
+    void    dragHead(const QPoint &pos);
 
 protected:
     virtual void paintEvent(QPaintEvent *event );
+    virtual bool eventFilter(QObject *watched, QEvent *event);
+    virtual void changeEvent(QEvent *event);
+    virtual void showEvent(QShowEvent *event);
+    virtual void hideEvent(QHideEvent *event);
 
 private slots:
     void connectButtonClicked();
     void disconnectButtonClicked();
+    void snapshotButtonClicked();
+    void colorSpaceChanged(int index);
+    void resolutionChanged(int index);
+    void adaptiveQualityToggled(bool enabled);
+    void filterToggled();
+    void analysisToggled(bool enabled);
+    void audioBufferChanged(int msec);
+    void updateStatus();
     void updateCameraView();
+    void replayPauseToggled(bool paused);
+    void replayPlayClicked();
+    void replaySliderChanged(int value);
+    void updateReplay();
+    void updateFrameDemand();
 
 signals:
     void consoleUpdated();
@@ -0,0 +1,52 @@
+/**
+ * Camera frame to QImage conversion for every NAO color space
+ * Created 2026/10/19
+ */
+
+#include "pixelconversion.h"
+
+using namespace PixelConversion;
+
+QImage::Format cameraImageFormat(int colorSpace)
+{
+    switch (colorSpace)
+    {
+    case NAO_CS_YUV422:
+    case NAO_CS_Y:
+        return QImage::Format_RGB32;
+    default:
+        return QImage::Format_RGB888;
+    }
+}
+
+bool convertCameraFrame(const uchar *src, int width, int height, int colorSpace, QImage &dst)
+{
+    if (src == NULL || width <= 0 || height <= 0)
+        return false;
+
+    QImage::Format format = cameraImageFormat(colorSpace);
+    if (dst.width() != width || dst.height() != height || dst.format() != format)
+    {
+        dst = QImage(width, height, format);
+    }
+
+    switch (colorSpace)
+    {
+    case NAO_CS_BGR:
+        convertFrame<NAO_CS_BGR, QImage::Format_RGB888>(src, width, height, dst);
+        break;
+    case NAO_CS_YUV422:
+        convertFrame<NAO_CS_YUV422, QImage::Format_RGB32>(src, width, height, dst);
+        break;
+    case NAO_CS_Y:
+        convertFrame<NAO_CS_Y, QImage::Format_RGB32>(src, width, height, dst);
+        break;
+    case NAO_CS_HSY:
+        convertFrame<NAO_CS_HSY, QImage::Format_RGB888>(src, width, height, dst);
+        break;
+    default:
+        convertFrame<NAO_CS_RGB, QImage::Format_RGB888>(src, width, height, dst);
+        break;
+    }
+    return true;
+}
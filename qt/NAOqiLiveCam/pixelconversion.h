@@ -0,0 +1,203 @@
+/**
+ * Camera frame to QImage conversion for every NAO color space
+ * Created 2026/10/19
+ */
+#ifndef PIXELCONVERSION_H
+#define PIXELCONVERSION_H
+
+#include <QImage>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "NAOqi/nao_interface/nao_interface.h"
+
+// Converts a camera frame delivered in any NaoColorSpace into dst. dst is
+// only reallocated when the geometry or the format changes.
+// Returns false when src is NULL.
+bool convertCameraFrame(const uchar *src, int width, int height, int colorSpace, QImage &dst);
+
+// QImage format convertCameraFrame() produces for the given color space.
+QImage::Format cameraImageFormat(int colorSpace);
+
+namespace PixelConversion
+{
+
+template <int ColorSpace> struct SourceTraits { enum { BytesPerPixel = 3 }; };
+template <> struct SourceTraits<NAO_CS_YUV422> { enum { BytesPerPixel = 2 }; };
+template <> struct SourceTraits<NAO_CS_Y> { enum { BytesPerPixel = 1 }; };
+
+inline uchar clampByte(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : (uchar) v);
+}
+
+// YCbCr (full range) to RGB with 6 bit fixed point coefficients. The SIMD
+// kernels use exactly the same arithmetic so every path gives identical output.
+inline void yuvToRgb(int y, int u, int v, uchar &r, uchar &g, uchar &b)
+{
+    int du = u - 128;
+    int dv = v - 128;
+    r = clampByte(y + ((90 * dv) >> 6));
+    g = clampByte(y - ((22 * du + 46 * dv) >> 6));
+    b = clampByte(y + ((113 * du) >> 6));
+}
+
+// NAO's HSY: hue (0-255 for a full turn), saturation and luma.
+inline void hsyToRgb(int h, int s, int y, uchar &r, uchar &g, uchar &b)
+{
+    int sector = h * 6 / 256;
+    int f = h * 6 - sector * 256;
+    int hr, hg, hb;
+    switch (sector)
+    {
+    case 0:  hr = 255;     hg = f;       hb = 0;       break;
+    case 1:  hr = 255 - f; hg = 255;     hb = 0;       break;
+    case 2:  hr = 0;       hg = 255;     hb = f;       break;
+    case 3:  hr = 0;       hg = 255 - f; hb = 255;     break;
+    case 4:  hr = f;       hg = 0;       hb = 255;     break;
+    default: hr = 255;     hg = 0;       hb = 255 - f; break;
+    }
+    int hy = (77 * hr + 150 * hg + 29 * hb) >> 8;
+    r = clampByte(y + (((hr - hy) * s) >> 8));
+    g = clampByte(y + (((hg - hy) * s) >> 8));
+    b = clampByte(y + (((hb - hy) * s) >> 8));
+}
+
+// Generic per row kernel, used for every combination without a specialization.
+template <int Src, QImage::Format Dst>
+struct RowKernel
+{
+    static inline void convert(const uchar *src, uchar *dst, int width)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            uchar r, g, b;
+            switch (Src)
+            {
+            case NAO_CS_RGB:    r = src[0]; g = src[1]; b = src[2]; src += 3; break;
+            case NAO_CS_BGR:    r = src[2]; g = src[1]; b = src[0]; src += 3; break;
+            case NAO_CS_HSY:    hsyToRgb(src[0], src[1], src[2], r, g, b); src += 3; break;
+            case NAO_CS_Y:      r = g = b = src[0]; src += 1; break;
+            default:            yuvToRgb(src[0], (x & 1) ? src[-1] : src[1], (x & 1) ? src[1] : src[3], r, g, b); src += 2; break;
+            }
+            if (Dst == QImage::Format_RGB32)
+            {
+                // 0xffRRGGBB, little endian in memory
+                dst[0] = b; dst[1] = g; dst[2] = r; dst[3] = 0xff;
+                dst += 4;
+            }
+            else
+            {
+                dst[0] = r; dst[1] = g; dst[2] = b;
+                dst += 3;
+            }
+        }
+    }
+};
+
+template <>
+struct RowKernel<NAO_CS_RGB, QImage::Format_RGB888>
+{
+    static inline void convert(const uchar *src, uchar *dst, int width)
+    {
+        memcpy(dst, src, width * 3);
+    }
+};
+
+template <>
+struct RowKernel<NAO_CS_Y, QImage::Format_RGB32>
+{
+    static inline void convert(const uchar *src, uchar *dst, int width)
+    {
+        int x = 0;
+#if defined(__SSE2__)
+        const __m128i alpha = _mm_set1_epi8((char) 0xff);
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i y = _mm_loadu_si128((const __m128i *)(src + x));
+            __m128i yyLo = _mm_unpacklo_epi8(y, y);
+            __m128i yyHi = _mm_unpackhi_epi8(y, y);
+            __m128i yaLo = _mm_unpacklo_epi8(y, alpha);
+            __m128i yaHi = _mm_unpackhi_epi8(y, alpha);
+            __m128i *out = (__m128i *)(dst + x * 4);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(yyLo, yaLo));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(yyLo, yaLo));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(yyHi, yaHi));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(yyHi, yaHi));
+        }
+#endif
+        for (uchar *p = dst + x * 4; x < width; x++, p += 4)
+        {
+            p[0] = p[1] = p[2] = src[x];
+            p[3] = 0xff;
+        }
+    }
+};
+
+template <>
+struct RowKernel<NAO_CS_YUV422, QImage::Format_RGB32>
+{
+    static inline void convert(const uchar *src, uchar *dst, int width)
+    {
+        int x = 0;
+#if defined(__SSE2__)
+        {
+            const __m128i lowByte = _mm_set1_epi16(0x00ff);
+            const __m128i lowWord = _mm_set1_epi32(0x0000ffff);
+            const __m128i bias = _mm_set1_epi16(128);
+            const __m128i alpha = _mm_set1_epi8((char) 0xff);
+            for (; x + 8 <= width; x += 8)
+            {
+                __m128i yuyv = _mm_loadu_si128((const __m128i *)(src + x * 2));
+                __m128i y = _mm_and_si128(yuyv, lowByte);
+                __m128i uv = _mm_srli_epi16(yuyv, 8);
+                __m128i u = _mm_and_si128(uv, lowWord);
+                __m128i v = _mm_srli_epi32(uv, 16);
+                u = _mm_sub_epi16(_mm_or_si128(u, _mm_slli_epi32(u, 16)), bias);
+                v = _mm_sub_epi16(_mm_or_si128(v, _mm_slli_epi32(v, 16)), bias);
+
+                __m128i r = _mm_add_epi16(y, _mm_srai_epi16(_mm_mullo_epi16(v, _mm_set1_epi16(90)), 6));
+                __m128i g = _mm_sub_epi16(y, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(22)),
+                                                                          _mm_mullo_epi16(v, _mm_set1_epi16(46))), 6));
+                __m128i b = _mm_add_epi16(y, _mm_srai_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(113)), 6));
+
+                __m128i r8 = _mm_packus_epi16(r, r);
+                __m128i g8 = _mm_packus_epi16(g, g);
+                __m128i b8 = _mm_packus_epi16(b, b);
+                __m128i bg = _mm_unpacklo_epi8(b8, g8);
+                __m128i ra = _mm_unpacklo_epi8(r8, alpha);
+                __m128i *out = (__m128i *)(dst + x * 4);
+                _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bg, ra));
+                _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bg, ra));
+            }
+        }
+#endif
+        // the scalar tail always starts on an even pixel
+        for (; x + 1 < width; x += 2)
+        {
+            const uchar *s = src + x * 2;
+            uchar *p = dst + x * 4;
+            yuvToRgb(s[0], s[1], s[3], p[2], p[1], p[0]);
+            yuvToRgb(s[2], s[1], s[3], p[6], p[5], p[4]);
+            p[3] = p[7] = 0xff;
+        }
+    }
+};
+
+// Whole frame converter; all of the specialization is in the row kernels.
+template <int Src, QImage::Format Dst>
+inline void convertFrame(const uchar *src, int width, int height, QImage &dst)
+{
+    const int srcStride = width * SourceTraits<Src>::BytesPerPixel;
+    for (int y = 0; y < height; y++)
+    {
+        RowKernel<Src, Dst>::convert(src + y * srcStride, dst.scanLine(y), width);
+    }
+}
+
+} // namespace PixelConversion
+
+#endif
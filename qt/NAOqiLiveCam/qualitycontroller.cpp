@@ -0,0 +1,162 @@
+/**
+ * Adaptive preview quality driven by the measured link round trip
+ * Created 2026/10/19
+ */
+
+#include "qualitycontroller.h"
+#include "NAOqi/nao_interface/nao_interface.h"
+
+static const int DOWNGRADE_WINDOWS = 2;     // congested windows before stepping down
+static const int UPGRADE_WINDOWS = 5;       // good windows before stepping up
+static const int HOLD_OFF_WINDOWS = 3;      // windows ignored after a change
+static const double CONGESTED_RATIO = 0.7;  // round trip / frame interval
+static const double HEADROOM_RATIO = 0.5;   // predicted round trip / frame interval
+static const int REDUCED_FPS = 6;           // frame rate caps of the lower rungs
+static const int MINIMUM_FPS = 3;
+
+static int bytesPerPixel(int colorSpace)
+{
+    switch (colorSpace)
+    {
+    case NAO_CS_YUV422: return 2;
+    case NAO_CS_Y:      return 1;
+    default:            return 3;
+    }
+}
+
+QualityController::QualityController()
+    :   m_enabled(false)
+{
+    Setting base = { NAO_RES_QVGA, NAO_CS_RGB, CAMERA_FPS };
+    reset(base);
+}
+
+// Appends setting as the next rung unless it is the same as the last one,
+// which happens when the base is already as cheap as the step.
+static void addRung(QVector<QualityController::Setting> &ladder, const QualityController::Setting &setting)
+{
+    const QualityController::Setting &last = ladder.last();
+    if (setting.resolution != last.resolution || setting.colorSpace != last.colorSpace || setting.fps != last.fps)
+        ladder.append(setting);
+}
+
+void QualityController::reset(const Setting &base)
+{
+    // Each step makes the previous rung cheaper: the two byte color space,
+    // a reduced frame rate, one resolution down, the minimum frame rate,
+    // another resolution down and finally luminance only. Steps never
+    // raise anything, so a cheap base gives a short ladder.
+    m_ladder.clear();
+    m_ladder.append(base);
+    Setting setting = base;
+    if (bytesPerPixel(NAO_CS_YUV422) < bytesPerPixel(setting.colorSpace))
+        setting.colorSpace = NAO_CS_YUV422;
+    addRung(m_ladder, setting);
+    setting.fps = qMin(setting.fps, REDUCED_FPS);
+    addRung(m_ladder, setting);
+    setting.resolution = qMax(setting.resolution - 1, (int) NAO_RES_QQVGA);
+    addRung(m_ladder, setting);
+    setting.fps = qMin(setting.fps, MINIMUM_FPS);
+    addRung(m_ladder, setting);
+    setting.resolution = qMax(setting.resolution - 1, (int) NAO_RES_QQVGA);
+    addRung(m_ladder, setting);
+    if (bytesPerPixel(NAO_CS_Y) < bytesPerPixel(setting.colorSpace))
+        setting.colorSpace = NAO_CS_Y;
+    addRung(m_ladder, setting);
+
+    m_level = 0;
+    m_frames = 0;
+    m_roundTripUSecs = 0;
+    m_bytes = 0;
+    m_avgRoundTripUSecs = 0;
+    m_throughput = 0;
+    m_congestedWindows = 0;
+    m_goodWindows = 0;
+    m_holdOffWindows = 0;
+    m_lastDecision = "";
+}
+
+QualityController::Setting QualityController::currentSetting() const
+{
+    return m_ladder[m_level];
+}
+
+int QualityController::bytesPerFrame(int level) const
+{
+    const Setting &setting = m_ladder[level];
+    return NaoInterface::resolutionWidth(setting.resolution) * NaoInterface::resolutionHeight(setting.resolution)
+            * bytesPerPixel(setting.colorSpace);
+}
+
+bool QualityController::addFrame(int roundTripUSecs, int bytes)
+{
+    m_frames++;
+    m_roundTripUSecs += roundTripUSecs;
+    m_bytes += bytes;
+
+    // one window is about a second worth of frames at the current rate, or
+    // a second spent waiting when the link is badly congested
+    if (m_frames < currentSetting().fps && m_roundTripUSecs < 1000000)
+        return false;
+
+    bool changed = evaluateWindow();
+    m_frames = 0;
+    m_roundTripUSecs = 0;
+    m_bytes = 0;
+    return changed;
+}
+
+bool QualityController::evaluateWindow()
+{
+    m_avgRoundTripUSecs = (int)(m_roundTripUSecs / m_frames);
+    m_throughput = m_roundTripUSecs > 0 ? (double)m_bytes * 1000000.0 / m_roundTripUSecs : 0;
+
+    if (!m_enabled)
+        return false;
+
+    if (m_holdOffWindows > 0)
+    {
+        m_holdOffWindows--;
+        return false;
+    }
+
+    double interval = 1000000.0 / currentSetting().fps;
+    if (m_avgRoundTripUSecs > interval * CONGESTED_RATIO)
+    {
+        m_goodWindows = 0;
+        if (++m_congestedWindows >= DOWNGRADE_WINDOWS && m_level < m_ladder.size() - 1)
+        {
+            m_level++;
+            m_congestedWindows = 0;
+            m_holdOffWindows = HOLD_OFF_WINDOWS;
+            m_lastDecision = QString("link congested (rtt %1 ms), quality level %2").arg(averageRoundTripMSecs()).arg(m_level);
+            return true;
+        }
+        return false;
+    }
+
+    m_congestedWindows = 0;
+    if (m_level == 0 || m_throughput <= 0)
+        return false;
+
+    // Would the next better level still leave enough headroom at the
+    // throughput measured now?
+    const Setting &better = m_ladder[m_level - 1];
+    double predicted = bytesPerFrame(m_level - 1) * 1000000.0 / m_throughput;
+    if (predicted < HEADROOM_RATIO * 1000000.0 / better.fps)
+    {
+        if (++m_goodWindows >= UPGRADE_WINDOWS)
+        {
+            m_level--;
+            m_goodWindows = 0;
+            m_holdOffWindows = HOLD_OFF_WINDOWS;
+            m_lastDecision = QString("link recovered (%1 kB/s), quality level %2").arg(throughputKBytes()).arg(m_level);
+            return true;
+        }
+    }
+    else
+    {
+        m_goodWindows = 0;
+    }
+    return false;
+}
@@ -0,0 +1,70 @@
+/**
+ * Adaptive preview quality driven by the measured link round trip
+ * Created 2026/10/19
+ */
+#ifndef QUALITYCONTROLLER_H
+#define QUALITYCONTROLLER_H
+
+#include <QString>
+#include <QVector>
+
+// Adapts the preview stream to the link. Every frame reports the
+// getImageRemote round trip and its size; once per window the controller
+// decides whether to step down the quality ladder (smaller color space,
+// lower frame rate, lower resolution) or back up towards the user's
+// setting. The ladder is built from the user's setting and only holds
+// rungs that are actually cheaper than the one above. Stepping down needs a couple of congested windows in a row,
+// stepping up several good ones, and every change is followed by a hold
+// off period so the stream does not oscillate.
+class QualityController
+{
+public:
+    struct Setting
+    {
+        int     resolution;
+        int     colorSpace;
+        int     fps;
+    };
+
+    QualityController();
+
+    // Rebuilds the ladder below base and returns to its top.
+    void    reset(const Setting &base);
+    void    setEnabled(bool enabled) { m_enabled = enabled; }
+    bool    isEnabled() const { return m_enabled; }
+
+    // Returns true when the setting changed.
+    bool    addFrame(int roundTripUSecs, int bytes);
+
+    Setting currentSetting() const;
+    int     level() const { return m_level; }
+    int     levelCount() const { return m_ladder.size(); }
+    QString lastDecision() const { return m_lastDecision; }
+
+    // link statistics of the last window
+    int     averageRoundTripMSecs() const { return m_avgRoundTripUSecs / 1000; }
+    int     throughputKBytes() const { return (int)(m_throughput / 1024); }
+
+private:
+    int     bytesPerFrame(int level) const;
+    bool    evaluateWindow();
+
+private:
+    bool        m_enabled;
+    QVector<Setting> m_ladder;     // best first, m_ladder[0] is the user's setting
+    int         m_level;
+
+    // current window
+    int         m_frames;
+    long long   m_roundTripUSecs;
+    long long   m_bytes;
+
+    int         m_avgRoundTripUSecs;
+    double      m_throughput;       // bytes per second while transferring
+    int         m_congestedWindows;
+    int         m_goodWindows;
+    int         m_holdOffWindows;
+    QString     m_lastDecision;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * Real input FFT for the audio spectrum view
+ * Created 2026/10/19
+ */
+
+#include <math.h>
+#include "realfft.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+RealFFT::RealFFT(int size)
+    :   m_size(size)
+    ,   m_half(size / 2)
+    ,   m_window(size)
+    ,   m_bitReverse(size / 2)
+    ,   m_twiddleRe(size / 2)
+    ,   m_twiddleIm(size / 2)
+    ,   m_postRe(size / 2)
+    ,   m_postIm(size / 2)
+    ,   m_re(size / 2)
+    ,   m_im(size / 2)
+{
+    int bits = 0;
+    while ((1 << bits) < m_half)
+        bits++;
+    for (int i = 0; i < m_half; i++)
+    {
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        m_bitReverse[i] = r;
+    }
+
+    // Hann window, scaled so a full scale sine peaks at 1.0
+    double sum = 0;
+    for (int i = 0; i < size; i++)
+    {
+        m_window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / (size - 1)));
+        sum += m_window[i];
+    }
+    for (int i = 0; i < size; i++)
+        m_window[i] = (float)(m_window[i] * 2.0 / sum);
+
+    // stage with butterfly span h uses entries [h - 1, 2h - 1)
+    for (int h = 1; h < m_half; h *= 2)
+    {
+        for (int j = 0; j < h; j++)
+        {
+            m_twiddleRe[h - 1 + j] = (float) cos(-M_PI * j / h);
+            m_twiddleIm[h - 1 + j] = (float) sin(-M_PI * j / h);
+        }
+    }
+
+    for (int k = 0; k < m_half; k++)
+    {
+        m_postRe[k] = (float) cos(-2.0 * M_PI * k / size);
+        m_postIm[k] = (float) sin(-2.0 * M_PI * k / size);
+    }
+}
+
+void RealFFT::complexTransform()
+{
+    float *re = m_re.data();
+    float *im = m_im.data();
+    const float *twRe = m_twiddleRe.constData();
+    const float *twIm = m_twiddleIm.constData();
+
+    for (int h = 1; h < m_half; h *= 2)
+    {
+        const float *wRe = twRe + h - 1;
+        const float *wIm = twIm + h - 1;
+        for (int block = 0; block < m_half; block += 2 * h)
+        {
+            float *aRe = re + block;
+            float *aIm = im + block;
+            float *bRe = aRe + h;
+            float *bIm = aIm + h;
+            int j = 0;
+#ifdef __SSE__
+            for (; j + 4 <= h; j += 4)
+            {
+                __m128 wr = _mm_loadu_ps(wRe + j);
+                __m128 wi = _mm_loadu_ps(wIm + j);
+                __m128 xr = _mm_loadu_ps(bRe + j);
+                __m128 xi = _mm_loadu_ps(bIm + j);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr));
+                __m128 ar = _mm_loadu_ps(aRe + j);
+                __m128 ai = _mm_loadu_ps(aIm + j);
+                _mm_storeu_ps(bRe + j, _mm_sub_ps(ar, tr));
+                _mm_storeu_ps(bIm + j, _mm_sub_ps(ai, ti));
+                _mm_storeu_ps(aRe + j, _mm_add_ps(ar, tr));
+                _mm_storeu_ps(aIm + j, _mm_add_ps(ai, ti));
+            }
+#endif
+            for (; j < h; j++)
+            {
+                float tr = wRe[j] * bRe[j] - wIm[j] * bIm[j];
+                float ti = wRe[j] * bIm[j] + wIm[j] * bRe[j];
+                bRe[j] = aRe[j] - tr;
+                bIm[j] = aIm[j] - ti;
+                aRe[j] += tr;
+                aIm[j] += ti;
+            }
+        }
+    }
+}
+
+void RealFFT::magnitudes(const float *input, float *output)
+{
+    float *re = m_re.data();
+    float *im = m_im.data();
+    const float *window = m_window.constData();
+    const int *bitReverse = m_bitReverse.constData();
+
+    // even samples as real part, odd samples as imaginary part
+    for (int n = 0; n < m_half; n++)
+    {
+        int r = bitReverse[n];
+        re[r] = input[2 * n] * window[2 * n];
+        im[r] = input[2 * n + 1] * window[2 * n + 1];
+    }
+
+    complexTransform();
+
+    // split the packed spectrum into the spectrum of the real input
+    const float *postRe = m_postRe.constData();
+    const float *postIm = m_postIm.constData();
+    for (int k = 0; k < m_half; k++)
+    {
+        int m = (m_half - k) & (m_half - 1);
+        float evenRe = 0.5f * (re[k] + re[m]);
+        float evenIm = 0.5f * (im[k] - im[m]);
+        float oddRe = 0.5f * (im[k] + im[m]);
+        float oddIm = -0.5f * (re[k] - re[m]);
+        float xRe = evenRe + postRe[k] * oddRe - postIm[k] * oddIm;
+        float xIm = evenIm + postRe[k] * oddIm + postIm[k] * oddRe;
+        output[k] = sqrtf(xRe * xRe + xIm * xIm);
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * Real input FFT for the audio spectrum view
+ * Created 2026/10/19
+ */
+#ifndef REALFFT_H
+#define REALFFT_H
+
+#include <QVector>
+
+// Real input FFT with a plan computed once. The N real samples are packed
+// into an N/2 point complex FFT (split real / imaginary arrays, radix 2)
+// whose butterflies run four at a time with SSE when available.
+class RealFFT
+{
+public:
+    explicit RealFFT(int size);     // size: power of two, >= 16
+
+    int     size() const { return m_size; }
+
+    // Windowed (Hann) transform of size samples; writes size/2 bin
+    // magnitudes normalized so a full scale sine gives about 1.0.
+    void    magnitudes(const float *input, float *output);
+
+private:
+    void    complexTransform();
+
+private:
+    int             m_size;
+    int             m_half;
+    QVector<float>  m_window;
+    QVector<int>    m_bitReverse;
+    QVector<float>  m_twiddleRe;    // per stage, concatenated
+    QVector<float>  m_twiddleIm;
+    QVector<float>  m_postRe;       // real split twiddles
+    QVector<float>  m_postIm;
+    QVector<float>  m_re;
+    QVector<float>  m_im;
+};
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * High resolution snapshot and burst capture
+ * Created 2026/10/19
+ */
+
+#include <QDebug>
+#include <QDir>
+#include <QDateTime>
+#include <QImage>
+#include <QRunnable>
+#include "snapshotcapture.h"
+#include "mainwindow.h"
+
+class SnapshotEncodeTask : public QRunnable
+{
+public:
+    SnapshotEncodeTask(SnapshotCapture *owner, int slot, const unsigned char *data, int width, int height, const QString &fileName)
+        :   m_owner(owner), m_slot(slot), m_data(data), m_width(width), m_height(height), m_fileName(fileName)
+    {
+    }
+
+    void run()
+    {
+        // wraps the arena slot without copying it
+        QImage img(m_data, m_width, m_height, m_width * 3, QImage::Format_RGB888);
+        if (!img.save(m_fileName))
+        {
+            MainWindow::consoleMessage(QString("ERROR: failed to save ").append(m_fileName));
+        }
+        m_owner->releaseSlot(m_slot);
+    }
+
+private:
+    SnapshotCapture         *m_owner;
+    int                     m_slot;
+    const unsigned char     *m_data;
+    int                     m_width;
+    int                     m_height;
+    QString                 m_fileName;
+};
+
+
+SnapshotCapture::SnapshotCapture()
+    :   m_quit(false)
+    ,   m_busy(false)
+    ,   m_resolution(NAO_RES_VGA)
+    ,   m_frames(1)
+    ,   m_arena(NULL)
+    ,   m_slotSize(0)
+{
+    int encoders = QThread::idealThreadCount() - 1;
+    m_encoders.setMaxThreadCount(encoders > 1 ? encoders : 1);
+}
+
+SnapshotCapture::~SnapshotCapture()
+{
+    m_quit = true;
+    m_requestSem.release();
+    wait(5000);
+
+    m_encoders.waitForDone();
+    delete [] m_arena;
+    m_arena = NULL;
+}
+
+bool SnapshotCapture::requestCapture(int resolution, int frames, const QString &directory)
+{
+    QMutexLocker lock(&m_mutex);
+
+    if (m_busy)
+        return false;
+
+    if (frames < 1)
+        frames = 1;
+    if (frames > SNAPSHOT_MAX_BURST)
+        frames = SNAPSHOT_MAX_BURST;
+
+    m_busy = true;
+    m_resolution = resolution;
+    m_frames = frames;
+    m_directory = directory;
+    m_requestSem.release();
+
+    return true;
+}
+
+bool SnapshotCapture::prepareArena(int resolution)
+{
+    int slotSize = NaoInterface::resolutionWidth(resolution) * NaoInterface::resolutionHeight(resolution) * 3;
+    if (m_arena && slotSize <= m_slotSize)
+        return true;
+
+    // The arena only ever grows, so after the first capture at a resolution
+    // long sessions do not allocate anymore.
+    m_encoders.waitForDone();
+    delete [] m_arena;
+    m_arena = new unsigned char[SNAPSHOT_MAX_BURST * slotSize];
+    m_slotSize = slotSize;
+
+    m_mutex.lock();
+    m_freeSlots.clear();
+    for (int i = 0; i < SNAPSHOT_MAX_BURST; i++)
+        m_freeSlots.append(i);
+    m_mutex.unlock();
+    m_freeSlotSem.acquire(m_freeSlotSem.available());
+    m_freeSlotSem.release(SNAPSHOT_MAX_BURST);
+
+    return m_arena != NULL;
+}
+
+int SnapshotCapture::acquireSlot()
+{
+    m_freeSlotSem.acquire();
+    QMutexLocker lock(&m_mutex);
+    return m_freeSlots.takeFirst();
+}
+
+void SnapshotCapture::releaseSlot(int slot)
+{
+    m_mutex.lock();
+    m_freeSlots.append(slot);
+    m_mutex.unlock();
+    m_freeSlotSem.release();
+}
+
+void SnapshotCapture::run()
+{
+    while(!m_quit)
+    {
+        m_requestSem.acquire();
+        if (m_quit)
+            break;
+
+        m_mutex.lock();
+        int resolution = m_resolution;
+        int frames = m_frames;
+        QString directory = m_directory;
+        m_mutex.unlock();
+
+        int captured = 0;
+        if (prepareArena(resolution) && NaoInterface::instance()->subscribeSnapshot(resolution, frames))
+        {
+            QString prefix = QDir(directory).filePath(QString("snapshot_%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+            for (int i = 0; i < frames && !m_quit; i++)
+            {
+                int slot = acquireSlot();
+                unsigned char *data = m_arena + slot * m_slotSize;
+                int width = 0;
+                int height = 0;
+                if (!NaoInterface::instance()->captureSnapshot(data, m_slotSize, &width, &height))
+                {
+                    releaseSlot(slot);
+                    break;
+                }
+                QString fileName = frames > 1 ? QString("%1_%2.png").arg(prefix).arg(i, 2, 10, QChar('0')) : prefix + ".png";
+                m_encoders.start(new SnapshotEncodeTask(this, slot, data, width, height, fileName));
+                captured++;
+            }
+            NaoInterface::instance()->unsubscribeSnapshot();
+        }
+
+        if (captured > 0)
+            MainWindow::consoleMessage(QString("snapshot: %1 frame(s) captured").arg(captured));
+        else
+            MainWindow::consoleMessage("ERROR: snapshot capture failed.");
+
+        m_mutex.lock();
+        m_busy = false;
+        m_mutex.unlock();
+    }
+}
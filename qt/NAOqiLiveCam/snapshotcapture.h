@@ -0,0 +1,59 @@
+/**
+ * High resolution snapshot and burst capture
+ * Created 2026/10/19
+ */
+#ifndef SNAPSHOTCAPTURE_H
+#define SNAPSHOTCAPTURE_H
+
+#include <QThread>
+#include <QSemaphore>
+#include <QMutex>
+#include <QList>
+#include <QString>
+#include <QThreadPool>
+
+#include "NAOqi/nao_interface/nao_interface.h"
+
+// Captures single frames or bursts from the high resolution snapshot
+// subscription. Frames are fetched on this thread into a preallocated arena
+// and handed to a pool of encoders which write them to disk, so neither the
+// GUI thread nor the preview timer is blocked by a capture.
+class SnapshotCapture : public QThread
+{
+    Q_OBJECT
+
+public:
+    SnapshotCapture();
+    virtual ~SnapshotCapture();
+
+    bool    requestCapture(int resolution, int frames, const QString &directory);
+
+    void    run();
+
+    // called by the encoder tasks
+    void    releaseSlot(int slot);
+
+private:
+    bool    prepareArena(int resolution);
+    int     acquireSlot();
+
+private:
+    bool                        m_quit;
+    bool                        m_busy;
+    QSemaphore                  m_requestSem;
+    QMutex                      m_mutex;
+
+    int                         m_resolution;
+    int                         m_frames;
+    QString                     m_directory;
+
+    // burst arena: SNAPSHOT_MAX_BURST slots of m_slotSize bytes, allocated once
+    unsigned char               *m_arena;
+    int                         m_slotSize;
+    QList<int>                  m_freeSlots;
+    QSemaphore                  m_freeSlotSem;
+
+    QThreadPool                 m_encoders;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * Widget drawing the audio spectrum
+ * Created 2026/10/19
+ */
+
+#include <QPainter>
+#include "spectrumwidget.h"
+#include "audiospectrum.h"
+
+static const int   REFRESH_MSEC = 33;
+static const float FLOOR_DB = -72.0f;
+static const float DECAY_DB = 1.5f;     // per refresh
+
+static float levelFraction(float db)
+{
+    return qBound(0.0f, (db - FLOOR_DB) / -FLOOR_DB, 1.0f);
+}
+
+SpectrumWidget::SpectrumWidget(QWidget *parent)
+    :   QWidget(parent)
+    ,   m_source(0)
+    ,   m_rmsDb(FLOOR_DB)
+    ,   m_peakDb(FLOOR_DB)
+    ,   m_peakHoldDb(FLOOR_DB)
+    ,   m_idleTicks(0)
+{
+    for (int i = 0; i < NUM_BANDS; i++)
+        m_bands[i] = FLOOR_DB;
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+void SpectrumWidget::setSource(AudioSpectrum *source)
+{
+    m_source = source;
+    if (m_source)
+        m_timer.start(REFRESH_MSEC);
+    else
+        m_timer.stop();
+}
+
+void SpectrumWidget::refresh()
+{
+    float bands[NUM_BANDS];
+    float rmsDb, peakDb;
+    if (m_source && m_source->analyze(bands, NUM_BANDS, &rmsDb, &peakDb))
+    {
+        m_idleTicks = 0;
+        // fast attack, slow release
+        for (int i = 0; i < NUM_BANDS; i++)
+            m_bands[i] = qMax(bands[i], m_bands[i] - DECAY_DB);
+        m_rmsDb = qMax(rmsDb, m_rmsDb - DECAY_DB);
+        m_peakDb = peakDb;
+        m_peakHoldDb = qMax(peakDb, m_peakHoldDb - DECAY_DB / 4);
+    }
+    else
+    {
+        // stream stopped: let the bars fall, then stop repainting
+        if (++m_idleTicks * DECAY_DB > -FLOOR_DB)
+            return;
+        for (int i = 0; i < NUM_BANDS; i++)
+            m_bands[i] -= DECAY_DB;
+        m_rmsDb -= DECAY_DB;
+        m_peakDb -= DECAY_DB;
+        m_peakHoldDb -= DECAY_DB;
+    }
+    update();
+}
+
+void SpectrumWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    const int meterHeight = 8;
+    const int w = width();
+    const int h = height() - meterHeight - 2;
+
+    // level meter: RMS bar, peak tick and peak hold tick
+    int rmsWidth = (int)(levelFraction(m_rmsDb) * w);
+    QColor meterColor = m_peakDb > -1.0f ? Qt::red : (m_peakDb > -12.0f ? Qt::yellow : Qt::green);
+    painter.fillRect(0, h + 2, rmsWidth, meterHeight, meterColor);
+    painter.fillRect((int)(levelFraction(m_peakDb) * (w - 2)), h + 2, 2, meterHeight, Qt::white);
+    painter.fillRect((int)(levelFraction(m_peakHoldDb) * (w - 2)), h + 2, 2, meterHeight, Qt::red);
+
+    // bands
+    int barWidth = qMax(1, w / NUM_BANDS);
+    for (int i = 0; i < NUM_BANDS; i++)
+    {
+        int barHeight = (int)(levelFraction(m_bands[i]) * h);
+        painter.fillRect(i * barWidth, h - barHeight, barWidth - 1, barHeight, QColor(80, 160, 255));
+    }
+}
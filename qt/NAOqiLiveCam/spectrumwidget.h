@@ -0,0 +1,41 @@
+/**
+ * Widget drawing the audio spectrum
+ * Created 2026/10/19
+ */
+#ifndef SPECTRUMWIDGET_H
+#define SPECTRUMWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+
+class AudioSpectrum;
+
+// Level meter and band spectrum of the robot microphone. Refreshes on its
+// own timer so the audio callback never waits on painting.
+class SpectrumWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SpectrumWidget(QWidget *parent = 0);
+
+    void    setSource(AudioSpectrum *source);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+
+private slots:
+    void    refresh();
+
+private:
+    enum { NUM_BANDS = 24 };
+
+    AudioSpectrum   *m_source;
+    QTimer          m_timer;
+    float           m_bands[NUM_BANDS];
+    float           m_rmsDb;
+    float           m_peakDb;
+    float           m_peakHoldDb;
+    int             m_idleTicks;
+};
+
+#endif